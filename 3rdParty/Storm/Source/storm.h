@@ -532,6 +532,10 @@ enum SFileFlags
 
 BOOL STORMAPI SFileReadFile(HANDLE hFile, void *buffer, DWORD nNumberOfBytesToRead, DWORD *read, LONG *lpDistanceToMoveHigh);
 
+// Points *data at the file inside the memory-mapped archive, fails unless
+// the file is stored uncompressed and unencrypted
+bool STORMAPI SFileMapFile(HANDLE hFile, const void **data);
+
 void STORMAPI SFileSetLocale(LCID lcLocale);
 
 // mode:    0 - Silent (callback is NULL)
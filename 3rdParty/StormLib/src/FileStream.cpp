@@ -23,7 +23,6 @@
 #include <psp2/io/fcntl.h>
 #include <psp2/io/stat.h>
 #include <psp2/rtc.h>
-#define mmap(ptr, size, c, d, e, f) malloc(size)
 #endif
 
 #ifdef _MSC_VER
@@ -219,16 +218,24 @@ static bool BaseFile_Read(
 	{
 		ssize_t bytes_read;
 
+#if defined(PLATFORM_AMIGA)
 		// If the byte offset is different from the current file position,
 		// we have to update the file position   xxx
 		if (ByteOffset != pStream->Base.File.FilePos) {
 			lseek64((intptr_t)pStream->Base.File.hFile, (off64_t)(ByteOffset), SEEK_SET);
 			pStream->Base.File.FilePos = ByteOffset;
 		}
+#endif
 
 		// Perform the read operation
 		if (dwBytesToRead != 0) {
+#if defined(PLATFORM_AMIGA)
 			bytes_read = read((intptr_t)pStream->Base.File.hFile, pvBuffer, (size_t)dwBytesToRead);
+#else
+			// Read at the offset without moving the file pointer,
+			// so that several threads can read the same archive
+			bytes_read = pread64((intptr_t)pStream->Base.File.hFile, pvBuffer, (size_t)dwBytesToRead, (off64_t)ByteOffset);
+#endif
 			if (bytes_read == -1) {
 				nLastError = errno;
 				return false;
@@ -435,12 +442,13 @@ static void BaseFile_Init(TFileStream *pStream)
 
 static bool BaseMap_Open(TFileStream *pStream, const TCHAR *szFileName, DWORD dwStreamFlags)
 {
+	bool bResult = false;
+
 #ifdef PLATFORM_WINDOWS
 
 	ULARGE_INTEGER FileSize;
 	HANDLE hFile;
 	HANDLE hMap;
-	bool bResult = false;
 
 	// Keep compiler happy
 	dwStreamFlags = dwStreamFlags;
@@ -476,25 +484,20 @@ static bool BaseMap_Open(TFileStream *pStream, const TCHAR *szFileName, DWORD dw
 		// Close the file handle
 		CloseHandle(hFile);
 	}
-
-	// If the file is not there and is not available for random access,
-	// report error
-	if (bResult == false)
-		return false;
 #endif
 
-#if defined(PLATFORM_MAC) || defined(PLATFORM_LINUX) || defined(PLATFORM_HAIKU) || defined(PLATFORM_AMIGA)
+#if (defined(PLATFORM_MAC) || defined(PLATFORM_LINUX) || defined(PLATFORM_HAIKU)) && !defined(PLATFORM_AMIGA)
 	struct stat64 fileinfo;
 	intptr_t handle;
-	bool bResult = false;
-#else
+	LPBYTE pbFile;
+
 	handle = open(szFileName, O_RDONLY);
 	if (handle != -1) {
-		// Get the file size
-		if (fstat64(handle, &fileinfo) != -1) {
-#if !defined(PLATFORM_AMIGA)
-			pStream->Base.Map.pbFile = (LPBYTE)mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
-			if (pStream->Base.Map.pbFile != NULL) {
+		// Get the file size. Don't allow mapping file of a zero size.
+		if (fstat64(handle, &fileinfo) != -1 && fileinfo.st_size != 0) {
+			pbFile = (LPBYTE)mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+			if (pbFile != (LPBYTE)MAP_FAILED) {
+				pStream->Base.Map.pbFile = pbFile;
 				// time_t is number of seconds since 1.1.1970, UTC.
 				// 1 second = 10000000 (decimal) in FILETIME
 				// Set the start to 1.1.1970 00:00:00
@@ -503,16 +506,16 @@ static bool BaseMap_Open(TFileStream *pStream, const TCHAR *szFileName, DWORD dw
 				pStream->Base.Map.FilePos  = 0;
 				bResult                    = true;
 			}
-#endif
 		}
 		close(handle);
 	}
 #endif
 
-	// Did the mapping fail?
+	// If the file can't be mapped (or the platform has no mmap),
+	// fall back to reading it through the plain file functions
 	if (bResult == false) {
-		nLastError = errno;
-		return false;
+		BaseFile_Init(pStream);
+		return BaseFile_Open(pStream, szFileName, dwStreamFlags);
 	}
 
 	return true;
@@ -532,12 +535,8 @@ static bool BaseMap_Read(
 		if ((ByteOffset + dwBytesToRead) > pStream->Base.Map.FileSize)
 			return false;
 
-			// Copy the required data
-#if !defined(PLATFORM_VITA)
+		// Copy the required data
 		memcpy(pvBuffer, pStream->Base.Map.pbFile + (size_t)ByteOffset, dwBytesToRead);
-#else
-		VitaAux::error("NOT Implemented!! Open the file and seek to the position");
-#endif
 	}
 
 	// Move the current file position
@@ -2426,6 +2425,28 @@ bool FileStream_SetCallback(TFileStream *pStream, SFILE_DOWNLOAD_CALLBACK pfnCal
 	return true;
 }
 
+/**
+ * Gives the address and size of a memory-mapped stream, so that callers
+ * can access its data in place instead of copying it out with FileStream_Read.
+ * Fails for streams that are not flat, fully present memory-mapped files.
+ *
+ * \a pStream Pointer to an open stream
+ * \a ppbFile Receives the address the file is mapped at
+ * \a pFileSize Receives the size of the mapping, in bytes
+ */
+
+bool FileStream_GetMapping(TFileStream *pStream, LPBYTE *ppbFile, ULONGLONG *pFileSize)
+{
+	if (pStream->BaseRead != BaseMap_Read || pStream->pMaster != NULL || pStream->BlockCheck != NULL)
+		return false;
+	if ((pStream->dwFlags & STREAM_PROVIDER_MASK) != STREAM_PROVIDER_FLAT)
+		return false;
+
+	*ppbFile   = pStream->Base.Map.pbFile;
+	*pFileSize = pStream->Base.Map.FileSize;
+	return true;
+}
+
 /**
  * This function gives the block map. The 'pvBitmap' pointer must point to a buffer
  * of at least sizeof(STREAM_BLOCK_MAP) size. It can also have size of the complete
@@ -806,6 +806,46 @@ DWORD STORMAPI SFileGetFileSize(HANDLE hFile, LPDWORD pdwFileSizeHigh)
     return SFILE_INVALID_SIZE;
 }
 
+//-----------------------------------------------------------------------------
+// SFileMapFile
+//
+// Gives a pointer to the file data inside a memory-mapped archive. Only works
+// for files that are stored as-is (not compressed, encrypted or patched),
+// everything else has to be read with SFileReadFile.
+
+bool STORMAPI SFileMapFile(HANDLE hFile, const void ** ppvData)
+{
+    TMPQFile * hf = (TMPQFile *)hFile;
+    TFileEntry * pFileEntry;
+    ULONGLONG MapSize;
+    LPBYTE pbMap;
+
+    if(!IsValidFileHandle(hFile) || ppvData == NULL)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    // Local files and patched files don't live in the archive as a whole
+    pFileEntry = hf->pFileEntry;
+    if(hf->pStream != NULL || hf->hfPatch != NULL || pFileEntry == NULL)
+        return false;
+    if(hf->ha->dwSubType != MPQ_SUBTYPE_MPQ)
+        return false;
+    if(pFileEntry->dwFlags & (MPQ_FILE_COMPRESS_MASK | MPQ_FILE_ENCRYPTED | MPQ_FILE_PATCH_FILE))
+        return false;
+    if(pFileEntry->dwCmpSize != pFileEntry->dwFileSize)
+        return false;
+
+    if(!FileStream_GetMapping(hf->ha->pStream, &pbMap, &MapSize))
+        return false;
+    if(hf->RawFilePos + pFileEntry->dwFileSize > MapSize)
+        return false;
+
+    *ppvData = pbMap + (size_t)hf->RawFilePos;
+    return true;
+}
+
 DWORD STORMAPI SFileSetFilePointer(HANDLE hFile, LONG lFilePos, LONG * plFilePosHigh, DWORD dwMoveMethod)
 {
     TMPQFile * hf = (TMPQFile *)hFile;
@@ -269,6 +269,7 @@ typedef char *LPSTR;
 #define stat64 stat
 #define fstat64 fstat
 #define lseek64 lseek
+#define pread64 pread
 #define ftruncate64 ftruncate
 #define off64_t off_t
 #define O_LARGEFILE 0
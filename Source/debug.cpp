@@ -230,6 +230,36 @@ void NextDebugMonster()
 	sprintf(dstr, "Current debug monster = %i", dbgmon);
 	NetSendCmdString(1 << myplr, dstr);
 }
+
+/**
+ * @brief Time 100000 rolls each of the monster, good and object drop tables
+ */
+void BenchmarkItemDrops()
+{
+	int i, m, seed, count;
+	DWORD ticks;
+	char dstr[128];
+
+	// put the seed back afterwards, other players would go out of sync otherwise
+	seed = sglGameSeed;
+	count = SeedCount;
+	ticks = SDL_GetTicks();
+	for (i = 0; i < 100000; i++) {
+		if (nummonsters != 0) {
+			m = monstactive[i % nummonsters];
+			if (monster[m].MData != NULL)
+				RndItem(m);
+		}
+		RndUItem(-1);
+		RndAllItems();
+	}
+	ticks = SDL_GetTicks() - ticks;
+	sglGameSeed = seed;
+	SeedCount = count;
+
+	sprintf(dstr, "100000 drops in %i ms", ticks);
+	NetSendCmdString(1 << myplr, dstr);
+}
 #endif
 
 DEVILUTION_END_NAMESPACE
@@ -21,6 +21,7 @@ void PrintDebugQuest();
 void PrintDebugMonster(int m);
 void GetDebugMonster();
 void NextDebugMonster();
+void BenchmarkItemDrops();
 #endif
 
 #endif /* __DEBUG_H__ */
@@ -72,10 +72,10 @@ void FreeGameMem()
 {
 	music_stop();
 
-	MemFreeDbg(pDungeonCels);
-	MemFreeDbg(pMegaTiles);
-	MemFreeDbg(pLevelPieces);
-	MemFreeDbg(pSpecialCels);
+	MemFreeView(pDungeonCels);
+	MemFreeView(pMegaTiles);
+	MemFreeView(pLevelPieces);
+	MemFreeView(pSpecialCels);
 
 	FreeMissiles();
 	FreeMonsters();
@@ -188,7 +188,9 @@ void run_game_loop(unsigned int uMsg)
 			DrawAndBlit();
 			continue;
 		}
+		profile_begin(PROF_NETWORK);
 		multi_process_network_packets();
+		profile_end(PROF_NETWORK);
 		game_loop(gbGameLoopStartup);
 		gbGameLoopStartup = FALSE;
 		DrawAndBlit();
@@ -235,6 +237,9 @@ void free_game()
 {
 	int i;
 
+	dx_present_stop();
+	prefetch_cleanup();
+	profile_free();
 	FreeControlPan();
 	FreeInvGFX();
 	FreeGMenu();
@@ -243,8 +248,10 @@ void free_game()
 
 	for (i = 0; i < MAX_PLRS; i++)
 		FreePlayerGFX(i);
+	plrgfx_free();
 
 	FreeItemGFX();
+	FreeItemLists();
 	FreeCursor();
 	FreeLightTable();
 	FreeDebugGFX();
@@ -297,6 +304,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 	diablo_init(lpCmdLine);
 	diablo_splash();
 	mainmenu_loop();
+	sthread_cleanup();
 	UiDestroy();
 	SaveGamma();
 
@@ -1404,6 +1412,10 @@ void PressChar(int vkey)
 			NetSendCmdString(1 << myplr, tempstr);
 		}
 		return;
+	case 'Y':
+	case 'y':
+		BenchmarkItemDrops();
+		return;
 	case '|':
 		if (currlevel == 0 && debug_mode_key_w) {
 			GiveGoldCheat();
@@ -1418,47 +1430,34 @@ void PressChar(int vkey)
 	}
 }
 
+/** CEL, TIL, MIN and special CEL files of each level type, see LoadLvlGFX */
+const char *const LvlGFXFiles[5][4] = {
+	// clang-format off
+	{ "Levels\\TownData\\Town.CEL", "Levels\\TownData\\Town.TIL", "Levels\\TownData\\Town.MIN", "Levels\\TownData\\TownS.CEL" },
+	{ "Levels\\L1Data\\L1.CEL",     "Levels\\L1Data\\L1.TIL",     "Levels\\L1Data\\L1.MIN",     "Levels\\L1Data\\L1S.CEL"     },
+	{ "Levels\\L2Data\\L2.CEL",     "Levels\\L2Data\\L2.TIL",     "Levels\\L2Data\\L2.MIN",     "Levels\\L2Data\\L2S.CEL"     },
+	{ "Levels\\L3Data\\L3.CEL",     "Levels\\L3Data\\L3.TIL",     "Levels\\L3Data\\L3.MIN",     "Levels\\L1Data\\L1S.CEL"     },
+	{ "Levels\\L4Data\\L4.CEL",     "Levels\\L4Data\\L4.TIL",     "Levels\\L4Data\\L4.MIN",     "Levels\\L2Data\\L2S.CEL"     },
+	// clang-format on
+};
+
 void LoadLvlGFX()
 {
 	/// ASSERT: assert(! pDungeonCels);
 
-	switch (leveltype) {
-	case DTYPE_TOWN:
-		pDungeonCels = LoadFileInMem("Levels\\TownData\\Town.CEL", NULL);
-		pMegaTiles = LoadFileInMem("Levels\\TownData\\Town.TIL", NULL);
-		pLevelPieces = LoadFileInMem("Levels\\TownData\\Town.MIN", NULL);
-		pSpecialCels = LoadFileInMem("Levels\\TownData\\TownS.CEL", NULL);
-		break;
-	case DTYPE_CATHEDRAL:
-		pDungeonCels = LoadFileInMem("Levels\\L1Data\\L1.CEL", NULL);
-		pMegaTiles = LoadFileInMem("Levels\\L1Data\\L1.TIL", NULL);
-		pLevelPieces = LoadFileInMem("Levels\\L1Data\\L1.MIN", NULL);
-		pSpecialCels = LoadFileInMem("Levels\\L1Data\\L1S.CEL", NULL);
-		break;
-#ifndef SPAWN
-	case DTYPE_CATACOMBS:
-		pDungeonCels = LoadFileInMem("Levels\\L2Data\\L2.CEL", NULL);
-		pMegaTiles = LoadFileInMem("Levels\\L2Data\\L2.TIL", NULL);
-		pLevelPieces = LoadFileInMem("Levels\\L2Data\\L2.MIN", NULL);
-		pSpecialCels = LoadFileInMem("Levels\\L2Data\\L2S.CEL", NULL);
-		break;
-	case DTYPE_CAVES:
-		pDungeonCels = LoadFileInMem("Levels\\L3Data\\L3.CEL", NULL);
-		pMegaTiles = LoadFileInMem("Levels\\L3Data\\L3.TIL", NULL);
-		pLevelPieces = LoadFileInMem("Levels\\L3Data\\L3.MIN", NULL);
-		pSpecialCels = LoadFileInMem("Levels\\L1Data\\L1S.CEL", NULL);
-		break;
-	case DTYPE_HELL:
-		pDungeonCels = LoadFileInMem("Levels\\L4Data\\L4.CEL", NULL);
-		pMegaTiles = LoadFileInMem("Levels\\L4Data\\L4.TIL", NULL);
-		pLevelPieces = LoadFileInMem("Levels\\L4Data\\L4.MIN", NULL);
-		pSpecialCels = LoadFileInMem("Levels\\L2Data\\L2S.CEL", NULL);
-		break;
+#ifdef SPAWN
+	if (leveltype != DTYPE_TOWN && leveltype != DTYPE_CATHEDRAL)
+#else
+	if (leveltype > DTYPE_HELL)
 #endif
-	default:
 		app_fatal("LoadLvlGFX");
-		break;
-	}
+
+	pDungeonCels = LoadFileView(LvlGFXFiles[leveltype][0], NULL);
+	pMegaTiles = LoadFileView(LvlGFXFiles[leveltype][1], NULL);
+	pLevelPieces = LoadFileView(LvlGFXFiles[leveltype][2], NULL);
+	pSpecialCels = LoadFileView(LvlGFXFiles[leveltype][3], NULL);
+
+	ClearTileCache();
 }
 
 void LoadAllGFX()
@@ -1527,6 +1526,7 @@ void LoadGameLevel(BOOL firstflag, int lvldir)
 	SetCursor_(CURSOR_HAND);
 #endif
 	SetRndSeed(glSeedTbl[currlevel]);
+	prefetch_wait(setlevel ? -1 : currlevel);
 	IncProgress();
 	MakeLightTable();
 	LoadLvlGFX();
@@ -1535,6 +1535,7 @@ void LoadGameLevel(BOOL firstflag, int lvldir)
 	if (firstflag) {
 		InitInv();
 		InitItemGFX();
+		InitItemLists();
 		InitQuestText();
 
 		for (i = 0; i < gbMaxPlayers; i++)
@@ -1733,6 +1734,7 @@ void LoadGameLevel(BOOL firstflag, int lvldir)
 		ProcessVisionList();
 	}
 
+	prefetch_level_loaded();
 	music_start(leveltype);
 
 	while (!IncProgress())
@@ -1780,20 +1782,39 @@ void game_logic()
 		CheckCursMove();
 		track_process();
 	}
+	plrgfx_update();
 	if (gbProcessPlayers) {
+		profile_begin(PROF_PLAYERS);
 		ProcessPlayers();
+		profile_end(PROF_PLAYERS);
 	}
 	if (leveltype != DTYPE_TOWN) {
+		profile_begin(PROF_MONSTERS);
 		ProcessMonsters();
+		profile_end(PROF_MONSTERS);
+		profile_begin(PROF_OBJECTS);
 		ProcessObjects();
+		profile_end(PROF_OBJECTS);
+		profile_begin(PROF_MISSILES);
 		ProcessMissiles();
+		profile_end(PROF_MISSILES);
+		profile_begin(PROF_ITEMS);
 		ProcessItems();
+		profile_end(PROF_ITEMS);
+		profile_begin(PROF_LIGHTS);
 		ProcessLightList();
+		profile_end(PROF_LIGHTS);
+		profile_begin(PROF_VISION);
 		ProcessVisionList();
+		profile_end(PROF_VISION);
 	} else {
 		ProcessTowners();
+		profile_begin(PROF_ITEMS);
 		ProcessItems();
+		profile_end(PROF_ITEMS);
+		profile_begin(PROF_MISSILES);
 		ProcessMissiles();
+		profile_end(PROF_MISSILES);
 	}
 
 #ifdef _DEBUG
@@ -1806,6 +1827,7 @@ void game_logic()
 	ClearPlrMsg();
 	CheckTriggers();
 	CheckQuests();
+	prefetch_update();
 	force_redraw |= 1;
 	pfile_update(FALSE);
 #ifdef VITA
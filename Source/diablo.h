@@ -77,8 +77,11 @@
 #ifdef VITA
 #include "../vita/plrctrls.h"
 #endif
+#include "plrgfx.h"
 #include "plrmsg.h"
 #include "portal.h"
+#include "prefetch.h"
+#include "profile.h"
 #include "quests.h"
 #include "restrict.h"
 #include "scrollrt.h"
@@ -87,6 +90,7 @@
 #include "sound.h"
 #include "spelldat.h"
 #include "spells.h"
+#include "sthread.h"
 #include "stores.h"
 #include "sync.h"
 #include "textdat.h" // check file name
@@ -192,6 +196,7 @@ extern int framestart;
 extern BOOL FriendlyMode;
 extern char *spszMsgTbl[4];
 extern char *spszMsgHotKeyTbl[4];
+extern const char *const LvlGFXFiles[5][4];
 
 #include "miniwin/popdecl.inc"
 DEVILUTION_END_NAMESPACE
@@ -6,12 +6,16 @@ extern BYTE *gpBuffer;
 extern char gbBackBuf;
 extern char gbEmulate;
 extern HMODULE ghDiabMod;
+extern unsigned int pal_surface_palette_version;
 
 void dx_init(HWND hWnd);
 void lock_buf(BYTE idx);
 void unlock_buf(BYTE idx);
 void dx_cleanup();
 void dx_reinit();
+void dx_present_start();
+void dx_present_stop();
+void GetPresentStats(DWORD *frames, DWORD *busyTicks, DWORD *dropped, DWORD *maxGap);
 
 void CreatePalette();
 void BltFast(DWORD dwX, DWORD dwY, LPRECT lpSrcRect);
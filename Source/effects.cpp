@@ -974,7 +974,6 @@ void FreeEffects()
 				if (pSnd) {
 					Monsters[i].Snds[j][k] = NULL;
 					file = pSnd->sound_path;
-					pSnd->sound_path = NULL;
 					sound_file_cleanup(pSnd);
 					mem_free_dbg(file);
 				}
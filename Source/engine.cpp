@@ -3,12 +3,33 @@
 
 DEVILUTION_BEGIN_NAMESPACE
 
+/** A game file shared read-only by everything that loaded it through LoadFileView */
+typedef struct FileView {
+	struct FileView *pNext;
+	BYTE *pData;
+	DWORD dwSize;
+	int nRefs;
+	BOOL bMapped;     // pData points into the memory-mapped archive
+	DWORD dwLastUse;  // release order, for evicting unreferenced views
+	char szName[MAX_PATH];
+} FileView;
+
 char gbPixelCol;  // automap pixel color 8-bit (palette entry)
 BOOL gbRotateMap; // flip - if y < x
 int orgseed;
 int sgnWidth;
 int sglGameSeed;
 static CCritSect sgMemCrit;
+static CCritSect sgViewCrit;
+static FileView *sgpFileViews;
+static BOOL sgbViewCacheInit;
+/** Bytes of unreferenced views that may stay cached */
+static DWORD sgdwViewBudget;
+static DWORD sgdwIdleViewBytes;
+static DWORD sgdwViewClock;
+static DWORD sgdwViewHits;
+static DWORD sgdwViewMisses;
+static DWORD sgdwViewBytesLoaded;
 int SeedCount;
 BOOL gbNotInView; // valid - if x/y are in bounds
 
@@ -857,6 +878,195 @@ DWORD LoadFileWithMem(const char *pszName, void *p)
 	return dwFileLen;
 }
 
+static FileView *FindFileView(const char *pszName)
+{
+	FileView *view;
+
+	for (view = sgpFileViews; view != NULL; view = view->pNext) {
+		if (!_strcmpi(view->szName, pszName))
+			return view;
+	}
+
+	return NULL;
+}
+
+static void FreeFileView(FileView *view)
+{
+	if (!view->bMapped)
+		mem_free_dbg(view->pData);
+	mem_free_dbg(view);
+}
+
+/**
+ * @brief Take a reference to a listed view, reviving it if it was only kept around by the cache
+ */
+static void RetainFileView(FileView *view)
+{
+	if (view->nRefs == 0)
+		sgdwIdleViewBytes -= view->dwSize;
+	view->nRefs++;
+}
+
+/**
+ * @brief Free the least recently used unreferenced views until they fit in the cache budget
+ */
+static void TrimFileViews()
+{
+	FileView **prev, **oldest, *view;
+
+	while (sgdwIdleViewBytes > sgdwViewBudget) {
+		oldest = NULL;
+		for (prev = &sgpFileViews; *prev != NULL; prev = &(*prev)->pNext) {
+			if ((*prev)->nRefs == 0 && (oldest == NULL || (*prev)->dwLastUse < (*oldest)->dwLastUse))
+				oldest = prev;
+		}
+		if (oldest == NULL)
+			break;
+		view = *oldest;
+		*oldest = view->pNext;
+		sgdwIdleViewBytes -= view->dwSize;
+		FreeFileView(view);
+	}
+}
+
+static void InitFileViewCache()
+{
+	int kb;
+
+	sgbViewCacheInit = TRUE;
+	kb = 32768;
+	if (!SRegLoadValue("devilutionx", "Asset Cache Size", 0, &kb))
+		SRegSaveValue("devilutionx", "Asset Cache Size", 0, kb);
+	sgdwViewBudget = kb > 0 ? kb * 1024 : 0;
+}
+
+/**
+ * @brief Load a file for read-only use, sharing it with anyone else who has it loaded
+ *
+ * Files stored uncompressed are returned straight from the memory-mapped
+ * archive, everything else is read once into a buffer. Once the last user
+ * releases a buffered file it stays cached, up to the "Asset Cache Size"
+ * setting, so that reloading it (e.g. on the next level of the same type)
+ * doesn't touch the archive again. The result must not be written to and is
+ * released with ReleaseFileView (or MemFreeView).
+ * @param pszName Path of the file in the archives
+ * @param pdwFileLen Receives the size of the file, if not NULL
+ * @return Pointer to the file data
+ */
+BYTE *LoadFileView(const char *pszName, DWORD *pdwFileLen)
+{
+	FileView *view, *other;
+	HANDLE file;
+	const void *mapped;
+
+	sgViewCrit.Enter();
+	view = FindFileView(pszName);
+	if (view != NULL) {
+		RetainFileView(view);
+		sgdwViewHits++;
+	}
+	sgViewCrit.Leave();
+
+	if (view == NULL) {
+		view = (FileView *)DiabloAllocPtr(sizeof(*view));
+		SStrCopy(view->szName, pszName, sizeof(view->szName));
+		view->nRefs = 1;
+
+		WOpenFile(pszName, &file, FALSE);
+		view->dwSize = WGetFileSize(file, NULL, pszName);
+		if (view->dwSize == 0)
+			app_fatal("Zero length SFILE:\n%s", pszName);
+
+		if (SFileMapFile(file, &mapped)) {
+			view->pData = (BYTE *)mapped;
+			view->bMapped = TRUE;
+		} else {
+			view->pData = DiabloAllocPtr(view->dwSize);
+			view->bMapped = FALSE;
+			WReadFile(file, view->pData, view->dwSize, pszName);
+		}
+		WCloseFile(file);
+
+		// someone else may have loaded the same file in the meantime
+		sgViewCrit.Enter();
+		sgdwViewMisses++;
+		sgdwViewBytesLoaded += view->dwSize;
+		other = FindFileView(pszName);
+		if (other == NULL) {
+			view->pNext = sgpFileViews;
+			sgpFileViews = view;
+		} else {
+			RetainFileView(other);
+		}
+		sgViewCrit.Leave();
+
+		if (other != NULL) {
+			FreeFileView(view);
+			view = other;
+		}
+	}
+
+	if (pdwFileLen)
+		*pdwFileLen = view->dwSize;
+
+	return view->pData;
+}
+
+/**
+ * @brief Drop a reference to a file loaded with LoadFileView
+ *
+ * With the last reference gone the file is either kept in the cache or freed.
+ */
+void ReleaseFileView(BYTE *p)
+{
+	FileView **prev, *view;
+
+	if (p == NULL)
+		return;
+
+	sgViewCrit.Enter();
+	if (!sgbViewCacheInit)
+		InitFileViewCache();
+	for (prev = &sgpFileViews; *prev != NULL; prev = &(*prev)->pNext) {
+		if ((*prev)->pData == p && (*prev)->nRefs != 0)
+			break;
+	}
+	view = *prev;
+	if (view == NULL) {
+		sgViewCrit.Leave();
+		app_fatal("ReleaseFileView: unknown view");
+	}
+	if (--view->nRefs == 0) {
+		// mapped files cost nothing to get back, so only buffers are worth keeping
+		if (view->bMapped || view->dwSize > sgdwViewBudget) {
+			*prev = view->pNext;
+			FreeFileView(view);
+		} else {
+			view->dwLastUse = ++sgdwViewClock;
+			sgdwIdleViewBytes += view->dwSize;
+			TrimFileViews();
+		}
+	}
+	sgViewCrit.Leave();
+}
+
+/**
+ * @brief Report the file view cache counters
+ * @param hits Number of loads served from an already loaded or cached file
+ * @param misses Number of loads that had to read the archive
+ * @param bytesLoaded Total bytes read from the archive by cache misses
+ * @param bytesCached Bytes currently held by files nobody is using
+ */
+void GetFileViewStats(DWORD *hits, DWORD *misses, DWORD *bytesLoaded, DWORD *bytesCached)
+{
+	sgViewCrit.Enter();
+	*hits = sgdwViewHits;
+	*misses = sgdwViewMisses;
+	*bytesLoaded = sgdwViewBytesLoaded;
+	*bytesCached = sgdwIdleViewBytes;
+	sgViewCrit.Leave();
+}
+
 /**
  * @brief Apply the color swaps to a CL2 sprite
  */
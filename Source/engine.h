@@ -8,6 +8,7 @@
 extern char gbPixelCol;  // automap pixel color 8-bit (palette entry)
 extern BOOL gbRotateMap; // flip - if y < x
 extern int orgseed;
+extern int sglGameSeed;
 extern int SeedCount;
 extern BOOL gbNotInView; // valid - if x/y are in bounds
 
@@ -69,6 +70,9 @@ BYTE *DiabloAllocPtr(DWORD dwBytes);
 void mem_free_dbg(void *p);
 BYTE *LoadFileInMem(char *pszName, DWORD *pdwFileLen);
 DWORD LoadFileWithMem(const char *pszName, void *p);
+BYTE *LoadFileView(const char *pszName, DWORD *pdwFileLen);
+void ReleaseFileView(BYTE *p);
+void GetFileViewStats(DWORD *hits, DWORD *misses, DWORD *bytesLoaded, DWORD *bytesCached);
 void Cl2ApplyTrans(BYTE *p, BYTE *ttbl, int nCel);
 void Cl2Draw(int sx, int sy, BYTE *pCelBuff, int nCel, int nWidth);
 void Cl2DrawOutline(char col, int sx, int sy, BYTE *pCelBuff, int nCel, int nWidth);
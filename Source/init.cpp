@@ -33,7 +33,11 @@ char gszProductName[MAX_PATH] = "Diablo v1.09";
 
 void init_cleanup()
 {
+	sthread_cleanup();
 	pfile_flush_W();
+	scrollrt_cleanup();
+	prefetch_cleanup();
+	plrgfx_cleanup();
 
 	if (diabdat_mpq) {
 		SFileCloseArchive(diabdat_mpq);
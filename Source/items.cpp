@@ -185,6 +185,11 @@ int ItemInvSnds[ITEMTYPES] = {
 };
 int idoppely = 16;
 int premiumlvladd[6] = { -1, -1, 0, 0, 1, 2 };
+/** Candidate lists of RndItem, RndUItem and RndAllItems back to back, see InitItemLists */
+static short *sgpItemListPool;
+/** Start of each list in sgpItemListPool by kind, game type and level, plus the end */
+static int *sgpItemListStart;
+static int sgnItemListLvls;
 
 void InitItemGFX()
 {
@@ -575,6 +580,7 @@ void CalcPlrItemVals(int p, BOOL Loadgfx)
 	if (plr[p]._pgfxnum != g && Loadgfx) {
 		plr[p]._pgfxnum = g;
 		plr[p]._pGFXLoad = 0;
+		plrgfx_cancel(p);
 		LoadPlrGFX(p, PFILE_STAND);
 		SetPlrAnims(p);
 
@@ -589,6 +595,8 @@ void CalcPlrItemVals(int p, BOOL Loadgfx)
 		plr[p]._pAnimDelay = 3;
 		plr[p]._pAnimWidth = plr[p]._pNWidth;
 		plr[p]._pAnimWidth2 = (plr[p]._pNWidth - 64) >> 1;
+		// only the files of the other animations are loaded in the background
+		plrgfx_request(p);
 	} else {
 		plr[p]._pgfxnum = g;
 	}
@@ -1810,63 +1818,52 @@ void SetupItem(int i)
 	}
 }
 
-int RndItem(int m)
+/**
+ * @brief Candidates of RndItem for a monster of the given level
+ *
+ * IDROP_DOUBLE items are listed twice. In single player the resurrect and
+ * heal other scrolls take the last entry off the list again, even when they
+ * weren't added themselves, the drops depend on that.
+ */
+static int ItemListDrop(int lvl, BOOL single, int *ril)
 {
 	int i, ri;
-	int ril[512];
-
-	if ((monster[m].MData->mTreasure & 0x8000) != 0)
-		return -1 - (monster[m].MData->mTreasure & 0xFFF);
-
-	if (monster[m].MData->mTreasure & 0x4000)
-		return 0;
-
-	if (random_(24, 100) > 40)
-		return 0;
-
-	if (random_(24, 100) > 25)
-		return 1;
 
 	ri = 0;
 	for (i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (AllItemsList[i].iRnd == 2 && monster[m].mLevel >= AllItemsList[i].iMinMLvl) {
+		if (AllItemsList[i].iRnd == 2 && lvl >= AllItemsList[i].iMinMLvl) {
 			ril[ri] = i;
 			ri++;
 		}
-		if (AllItemsList[i].iRnd && monster[m].mLevel >= AllItemsList[i].iMinMLvl) {
+		if (AllItemsList[i].iRnd && lvl >= AllItemsList[i].iMinMLvl) {
 			ril[ri] = i;
 			ri++;
 		}
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && gbMaxPlayers == 1)
+		// the old scans went below 0 here on levels nothing drops at, never to be read
+		if (AllItemsList[i].iSpell == SPL_RESURRECT && single && ri > 0)
 			ri--;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && gbMaxPlayers == 1)
+		if (AllItemsList[i].iSpell == SPL_HEALOTHER && single && ri > 0)
 			ri--;
 	}
 
-	return ril[random_(24, ri)] + 1;
+	return ri;
 }
 
-int RndUItem(int m)
+/**
+ * @brief Candidates of RndUItem, no gold, misc or ears apart from books
+ */
+static int ItemListGood(int lvl, BOOL single, int *ril)
 {
 	int i, ri;
-	int ril[512];
 	BOOL okflag;
 
-	if (m != -1 && (monster[m].MData->mTreasure & 0x8000) != 0 && gbMaxPlayers == 1)
-		return -1 - (monster[m].MData->mTreasure & 0xFFF);
-
 	ri = 0;
 	for (i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
 		okflag = TRUE;
 		if (!AllItemsList[i].iRnd)
 			okflag = FALSE;
-		if (m != -1) {
-			if (monster[m].mLevel < AllItemsList[i].iMinMLvl)
-				okflag = FALSE;
-		} else {
-			if (2 * currlevel < AllItemsList[i].iMinMLvl)
-				okflag = FALSE;
-		}
+		if (lvl < AllItemsList[i].iMinMLvl)
+			okflag = FALSE;
 		if (AllItemsList[i].itype == ITYPE_MISC)
 			okflag = FALSE;
 		if (AllItemsList[i].itype == ITYPE_GOLD)
@@ -1875,9 +1872,9 @@ int RndUItem(int m)
 			okflag = FALSE;
 		if (AllItemsList[i].iMiscId == IMISC_BOOK)
 			okflag = TRUE;
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && gbMaxPlayers == 1)
+		if (AllItemsList[i].iSpell == SPL_RESURRECT && single)
 			okflag = FALSE;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && gbMaxPlayers == 1)
+		if (AllItemsList[i].iSpell == SPL_HEALOTHER && single)
 			okflag = FALSE;
 		if (okflag) {
 			ril[ri] = i;
@@ -1885,30 +1882,142 @@ int RndUItem(int m)
 		}
 	}
 
-	return ril[random_(25, ri)];
+	return ri;
 }
 
-int RndAllItems()
+/**
+ * @brief Candidates of RndAllItems, with the same single player quirk as ItemListDrop
+ */
+static int ItemListAll(int lvl, BOOL single, int *ril)
 {
 	int i, ri;
-	int ril[512];
-
-	if (random_(26, 100) > 25)
-		return 0;
 
 	ri = 0;
 	for (i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (AllItemsList[i].iRnd && 2 * currlevel >= AllItemsList[i].iMinMLvl) {
+		if (AllItemsList[i].iRnd && lvl >= AllItemsList[i].iMinMLvl) {
 			ril[ri] = i;
 			ri++;
 		}
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && gbMaxPlayers == 1)
+		// the old scans went below 0 here on levels nothing drops at, never to be read
+		if (AllItemsList[i].iSpell == SPL_RESURRECT && single && ri > 0)
 			ri--;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && gbMaxPlayers == 1)
+		if (AllItemsList[i].iSpell == SPL_HEALOTHER && single && ri > 0)
 			ri--;
 	}
 
-	return ril[random_(26, ri)];
+	return ri;
+}
+
+static int ItemListBuild(int kind, int lvl, BOOL single, int *ril)
+{
+	switch (kind) {
+	case ILIST_DROP:
+		return ItemListDrop(lvl, single, ril);
+	case ILIST_GOOD:
+		return ItemListGood(lvl, single, ril);
+	default:
+		return ItemListAll(lvl, single, ril);
+	}
+}
+
+/**
+ * @brief Build the candidate lists of RndItem, RndUItem and RndAllItems
+ *
+ * AllItemsList doesn't change, so there is one list for every kind, game type
+ * and level up to the highest iMinMLvl of a dropping item. Higher levels get
+ * the same list as that one.
+ */
+void InitItemLists()
+{
+	int i, kind, single, lvl, idx, ri, n;
+	int ril[512];
+
+	sgnItemListLvls = 1;
+	for (i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+		if (AllItemsList[i].iRnd && AllItemsList[i].iMinMLvl >= sgnItemListLvls)
+			sgnItemListLvls = AllItemsList[i].iMinMLvl + 1;
+	}
+
+	n = NUM_ITEM_LISTS * 2 * sgnItemListLvls;
+	sgpItemListStart = (int *)DiabloAllocPtr((n + 1) * sizeof(int));
+	ri = 0;
+	for (idx = 0; idx < n; idx++) {
+		kind = idx / (2 * sgnItemListLvls);
+		single = (idx / sgnItemListLvls) & 1;
+		lvl = idx % sgnItemListLvls;
+		sgpItemListStart[idx] = ri;
+		ri += ItemListBuild(kind, lvl, single, ril);
+	}
+	sgpItemListStart[n] = ri;
+
+	// one spare entry, an empty list reads it like the old code read ril[0]
+	sgpItemListPool = (short *)DiabloAllocPtr((ri + 1) * sizeof(short));
+	sgpItemListPool[ri] = 0;
+	for (idx = 0; idx < n; idx++) {
+		kind = idx / (2 * sgnItemListLvls);
+		single = (idx / sgnItemListLvls) & 1;
+		lvl = idx % sgnItemListLvls;
+		ri = ItemListBuild(kind, lvl, single, ril);
+		for (i = 0; i < ri; i++)
+			sgpItemListPool[sgpItemListStart[idx] + i] = ril[i];
+	}
+}
+
+void FreeItemLists()
+{
+	MemFreeDbg(sgpItemListStart);
+	MemFreeDbg(sgpItemListPool);
+}
+
+/**
+ * @brief Pick a random entry of a candidate list, draws from the seed exactly like the list scans did
+ */
+static int ItemListPick(int kind, int lvl, int rndIdx)
+{
+	int idx, n;
+
+	// no monster or dungeon level is below 0
+	if (lvl < 0)
+		lvl = 0;
+	if (lvl >= sgnItemListLvls)
+		lvl = sgnItemListLvls - 1;
+	idx = (kind * 2 + (gbMaxPlayers == 1)) * sgnItemListLvls + lvl;
+	n = sgpItemListStart[idx + 1] - sgpItemListStart[idx];
+
+	return sgpItemListPool[sgpItemListStart[idx] + random_(rndIdx, n)];
+}
+
+int RndItem(int m)
+{
+	if ((monster[m].MData->mTreasure & 0x8000) != 0)
+		return -1 - (monster[m].MData->mTreasure & 0xFFF);
+
+	if (monster[m].MData->mTreasure & 0x4000)
+		return 0;
+
+	if (random_(24, 100) > 40)
+		return 0;
+
+	if (random_(24, 100) > 25)
+		return 1;
+
+	return ItemListPick(ILIST_DROP, monster[m].mLevel, 24) + 1;
+}
+
+int RndUItem(int m)
+{
+	if (m != -1 && (monster[m].MData->mTreasure & 0x8000) != 0 && gbMaxPlayers == 1)
+		return -1 - (monster[m].MData->mTreasure & 0xFFF);
+
+	return ItemListPick(ILIST_GOOD, m != -1 ? monster[m].mLevel : 2 * currlevel, 25);
+}
+
+int RndAllItems()
+{
+	if (random_(26, 100) > 25)
+		return 0;
+
+	return ItemListPick(ILIST_ALL, 2 * currlevel, 26);
 }
 
 int RndTypeItems(int itype, int imid)
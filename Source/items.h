@@ -15,6 +15,8 @@ extern int numitems;
 extern int gnNumGetRecords;
 
 void InitItemGFX();
+void InitItemLists();
+void FreeItemLists();
 BOOL ItemPlace(int xp, int yp);
 void AddInitItems();
 void InitItems();
@@ -1,4 +1,13 @@
 #include "diablo.h"
+#include "../3rdParty/Storm/Source/storm.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define LIGHT_NEON
+#include <arm_neon.h>
+#endif
 
 DEVILUTION_BEGIN_NAMESPACE
 
@@ -16,6 +25,66 @@ int visionid;
 BYTE *pLightTbl;
 BOOL lightflag;
 
+// DoLighting reaches at most 14 tiles from the light in every direction
+#define LIGHT_STAMP_RADIUS 14
+#define LIGHT_STAMP_SIZE (2 * LIGHT_STAMP_RADIUS + 1)
+// rows are padded with unlit cells so a whole row is two 16 byte vectors
+#define LIGHT_STAMP_PITCH 32
+#define LIGHT_STAMP_NONE 0xFF
+// lightradius value past the end of a light, taking the min with it never changes dLight
+#define LIGHT_STAMP_DARK 15
+
+/**
+ * The cells DoLighting lights for one radius and sub-tile offset, stored
+ * like dLight so each row of the stamp is a run of dLight[x][y] along y.
+ */
+typedef struct LightStamp {
+	BOOL valid;
+	// first and last lit column of each row, LIGHT_STAMP_SIZE and -1 if there is none
+	char lo[LIGHT_STAMP_SIZE];
+	char hi[LIGHT_STAMP_SIZE];
+	// bounding box of the cells brighter than LIGHT_STAMP_DARK, relative to the light
+	char x0;
+	char y0;
+	char x1;
+	char y1;
+	BYTE v[LIGHT_STAMP_SIZE][LIGHT_STAMP_PITCH];
+} LightStamp;
+
+static LightStamp lightstamps[16][64];
+
+// the incremental light map is split in regions of 8x8 tiles
+#define LIGHT_REGION_SHIFT 3
+#define LIGHT_REGIONS_X (MAXDUNX >> LIGHT_REGION_SHIFT)
+#define LIGHT_REGIONS_Y (MAXDUNY >> LIGHT_REGION_SHIFT)
+
+/**
+ * What DoLighting was last called with for a light and the regions the
+ * result touched.
+ */
+typedef struct LightFootprint {
+	BOOL stamped;
+	int x;
+	int y;
+	int r;
+	int xoff;
+	int yoff;
+	int rx0;
+	int ry0;
+	int rx1;
+	int ry1;
+} LightFootprint;
+
+static BOOL sgbLightIncrInit;
+// 0 unlight and relight like before, 1 keep the light map per region, 2 also check every update against a full recompute
+static int sgnLightIncremental;
+static BOOL sgbLightRegionsValid;
+static LightFootprint sgLightFootprints[MAXLIGHTS];
+// bit n is set if light n touches the region
+static DWORD sgdwLightRegionMask[LIGHT_REGIONS_X][LIGHT_REGIONS_Y];
+// dLight as ProcessLightList left it, to notice when something else (loading a game or level) rewrites it
+static char sgLightShadow[MAXDUNX][MAXDUNY];
+
 // CrawlTable specifies X- and Y-coordinate deltas from a missile target
 // coordinate.
 //
@@ -501,19 +570,145 @@ void RotateRadius(int *x, int *y, int *dx, int *dy, int *lx, int *ly, int *bx, i
 	}
 }
 
-void DoLighting(int nXPos, int nYPos, int nRadius, int Lnum)
+/**
+ * @brief dst[i] = min(dst[i], src[i]) for n light levels
+ */
+static void LightMinLine(BYTE *dst, const BYTE *src, int n)
 {
-	int x, y, v, xoff, yoff, mult, radius_block;
-	int min_x, max_x, min_y, max_y;
-	int dist_x, dist_y, light_x, light_y, block_x, block_y, temp_x, temp_y;
+	int i;
 
-	xoff = 0;
-	yoff = 0;
+#if defined(LIGHT_SSE2)
+	for (; n >= 16; n -= 16, dst += 16, src += 16) {
+		_mm_storeu_si128((__m128i *)dst, _mm_min_epu8(_mm_loadu_si128((const __m128i *)dst), _mm_loadu_si128((const __m128i *)src)));
+	}
+#elif defined(LIGHT_NEON)
+	for (; n >= 16; n -= 16, dst += 16, src += 16) {
+		vst1q_u8(dst, vminq_u8(vld1q_u8(dst), vld1q_u8(src)));
+	}
+#endif
+	for (i = 0; i < n; i++) {
+		if (src[i] < dst[i])
+			dst[i] = src[i];
+	}
+}
+
+/**
+ * @brief run the four quadrant loops of DoLighting once, without clipping, into a stamp
+ */
+static void MakeLightStamp(LightStamp *stamp, int nRadius, int xoff, int yoff)
+{
+	int q, x, y, dx, dy, mult, radius_block;
+	int dist_x, dist_y, light_x, light_y, block_x, block_y;
+
+	dist_x = xoff;
+	dist_y = yoff;
 	light_x = 0;
 	light_y = 0;
 	block_x = 0;
 	block_y = 0;
 
+	memset(stamp->v, LIGHT_STAMP_NONE, sizeof(stamp->v));
+	stamp->v[LIGHT_STAMP_RADIUS][LIGHT_STAMP_RADIUS] = 0;
+	for (q = 0; q < 4; q++) {
+		if (q != 0)
+			RotateRadius(&xoff, &yoff, &dist_x, &dist_y, &light_x, &light_y, &block_x, &block_y);
+		mult = xoff + 8 * yoff;
+		for (y = 0; y <= LIGHT_STAMP_RADIUS; y++) {
+			for (x = 1; x <= LIGHT_STAMP_RADIUS; x++) {
+				radius_block = lightblock[0][mult][y + block_y][x + block_x];
+				if (radius_block >= 128)
+					continue;
+				switch (q) {
+				case 0:
+					dx = x;
+					dy = y;
+					break;
+				case 1:
+					dx = y;
+					dy = -x;
+					break;
+				case 2:
+					dx = -x;
+					dy = -y;
+					break;
+				default:
+					dx = -y;
+					dy = x;
+					break;
+				}
+				stamp->v[dx + LIGHT_STAMP_RADIUS][dy + LIGHT_STAMP_RADIUS] = lightradius[nRadius][radius_block];
+			}
+		}
+	}
+
+	for (x = 0; x < LIGHT_STAMP_SIZE; x++) {
+		stamp->lo[x] = LIGHT_STAMP_SIZE;
+		stamp->hi[x] = -1;
+		for (y = 0; y < LIGHT_STAMP_SIZE; y++) {
+			if (stamp->v[x][y] == LIGHT_STAMP_NONE || x == LIGHT_STAMP_RADIUS && y == LIGHT_STAMP_RADIUS)
+				continue;
+			if (stamp->lo[x] > y)
+				stamp->lo[x] = y;
+			stamp->hi[x] = y;
+		}
+	}
+
+	stamp->x0 = LIGHT_STAMP_RADIUS;
+	stamp->y0 = LIGHT_STAMP_RADIUS;
+	stamp->x1 = -LIGHT_STAMP_RADIUS;
+	stamp->y1 = -LIGHT_STAMP_RADIUS;
+	for (x = 0; x < LIGHT_STAMP_SIZE; x++) {
+		for (y = 0; y < LIGHT_STAMP_SIZE; y++) {
+			if (stamp->v[x][y] >= LIGHT_STAMP_DARK)
+				continue;
+			dx = x - LIGHT_STAMP_RADIUS;
+			dy = y - LIGHT_STAMP_RADIUS;
+			if (stamp->x0 > dx)
+				stamp->x0 = dx;
+			if (stamp->x1 < dx)
+				stamp->x1 = dx;
+			if (stamp->y0 > dy)
+				stamp->y0 = dy;
+			if (stamp->y1 < dy)
+				stamp->y1 = dy;
+		}
+	}
+	stamp->valid = TRUE;
+}
+
+/**
+ * @brief apply columns [lo,hi] (relative to the light) of one stamp row to dLight[nXPos][nYPos + lo...]
+ */
+static void LightStampSpan(const LightStamp *stamp, int row, int nXPos, int nYPos, int lo, int hi)
+{
+	if (lo < stamp->lo[row] - LIGHT_STAMP_RADIUS)
+		lo = stamp->lo[row] - LIGHT_STAMP_RADIUS;
+	if (hi > stamp->hi[row] - LIGHT_STAMP_RADIUS)
+		hi = stamp->hi[row] - LIGHT_STAMP_RADIUS;
+	if (lo < -nYPos)
+		lo = -nYPos;
+	if (hi > MAXDUNY - 1 - nYPos)
+		hi = MAXDUNY - 1 - nYPos;
+	if (lo > hi)
+		return;
+	LightMinLine((BYTE *)&dLight[nXPos][nYPos + lo], &stamp->v[row][lo + LIGHT_STAMP_RADIUS], hi - lo + 1);
+}
+
+/**
+ * @brief light the area around (nXPos,nYPos) by taking the minimum of dLight and a precomputed stamp
+ *
+ * Near the edges of the map the four quadrants are clipped exactly like the
+ * original per-cell loops, which use the limit of one axis for the other.
+ */
+void DoLighting(int nXPos, int nYPos, int nRadius, int Lnum)
+{
+	int x, xoff, yoff, row;
+	int min_x, max_x, min_y, max_y;
+	LightStamp *stamp;
+
+	xoff = 0;
+	yoff = 0;
+
 	if (Lnum >= 0) {
 		xoff = LightList[Lnum]._xoff;
 		yoff = LightList[Lnum]._yoff;
@@ -527,9 +722,6 @@ void DoLighting(int nXPos, int nYPos, int nRadius, int Lnum)
 		}
 	}
 
-	dist_x = xoff;
-	dist_y = yoff;
-
 	if (nXPos - 15 < 0) {
 		min_x = nXPos + 1;
 	} else {
@@ -555,71 +747,42 @@ void DoLighting(int nXPos, int nYPos, int nRadius, int Lnum)
 		dLight[nXPos][nYPos] = 0;
 	}
 
-	mult = xoff + 8 * yoff;
-	for (y = 0; y < min_y; y++) {
-		for (x = 1; x < max_x; x++) {
-			radius_block = lightblock[0][mult][y][x];
-			if (radius_block < 128) {
-				temp_x = nXPos + x;
-				temp_y = nYPos + y;
-				v = lightradius[nRadius][radius_block];
-				if (temp_x >= 0 && temp_x < MAXDUNX && temp_y >= 0 && temp_y < MAXDUNY) {
-					if (v < dLight[temp_x][temp_y]) {
-						dLight[temp_x][temp_y] = v;
-					}
-				}
-			}
-		}
-	}
-	RotateRadius(&xoff, &yoff, &dist_x, &dist_y, &light_x, &light_y, &block_x, &block_y);
-	mult = xoff + 8 * yoff;
-	for (y = 0; y < max_y; y++) {
-		for (x = 1; x < max_x; x++) {
-			radius_block = lightblock[0][mult][y + block_y][x + block_x];
-			if (radius_block < 128) {
-				temp_x = nXPos + y;
-				temp_y = nYPos - x;
-				v = lightradius[nRadius][radius_block];
-				if (temp_x >= 0 && temp_x < MAXDUNX && temp_y >= 0 && temp_y < MAXDUNY) {
-					if (v < dLight[temp_x][temp_y]) {
-						dLight[temp_x][temp_y] = v;
-					}
-				}
-			}
-		}
-	}
-	RotateRadius(&xoff, &yoff, &dist_x, &dist_y, &light_x, &light_y, &block_x, &block_y);
-	mult = xoff + 8 * yoff;
-	for (y = 0; y < max_y; y++) {
-		for (x = 1; x < min_x; x++) {
-			radius_block = lightblock[0][mult][y + block_y][x + block_x];
-			if (radius_block < 128) {
-				temp_x = nXPos - x;
-				temp_y = nYPos - y;
-				v = lightradius[nRadius][radius_block];
-				if (temp_x >= 0 && temp_x < MAXDUNX && temp_y >= 0 && temp_y < MAXDUNY) {
-					if (v < dLight[temp_x][temp_y]) {
-						dLight[temp_x][temp_y] = v;
-					}
-				}
-			}
+	stamp = &lightstamps[nRadius][xoff + 8 * yoff];
+	if (!stamp->valid)
+		MakeLightStamp(stamp, nRadius, xoff, yoff);
+
+	if (min_x == 15 && max_x == 15 && min_y == 15 && nYPos + LIGHT_STAMP_PITCH - LIGHT_STAMP_RADIUS <= MAXDUNY) {
+		// nothing to clip, apply whole padded rows
+		for (row = 0; row < LIGHT_STAMP_SIZE; row++) {
+			LightMinLine((BYTE *)&dLight[nXPos + row - LIGHT_STAMP_RADIUS][nYPos - LIGHT_STAMP_RADIUS], stamp->v[row], LIGHT_STAMP_PITCH);
 		}
+		return;
 	}
-	RotateRadius(&xoff, &yoff, &dist_x, &dist_y, &light_x, &light_y, &block_x, &block_y);
-	mult = xoff + 8 * yoff;
-	for (y = 0; y < min_y; y++) {
-		for (x = 1; x < min_x; x++) {
-			radius_block = lightblock[0][mult][y + block_y][x + block_x];
-			if (radius_block < 128) {
-				temp_x = nXPos - y;
-				temp_y = nYPos + x;
-				v = lightradius[nRadius][radius_block];
-				if (temp_x >= 0 && temp_x < MAXDUNX && temp_y >= 0 && temp_y < MAXDUNY) {
-					if (v < dLight[temp_x][temp_y]) {
-						dLight[temp_x][temp_y] = v;
-					}
-				}
-			}
+
+	// each row is split in two halves that belong to different quadrants
+	min_x--;
+	max_x--;
+	min_y--;
+	max_y--;
+	for (x = -LIGHT_STAMP_RADIUS; x <= LIGHT_STAMP_RADIUS; x++) {
+		if (nXPos + x < 0 || nXPos + x >= MAXDUNX)
+			continue;
+		row = x + LIGHT_STAMP_RADIUS;
+		if (x > 0) {
+			if (x <= max_y)
+				LightStampSpan(stamp, row, nXPos + x, nYPos, -max_x, -1);
+			if (x <= max_x)
+				LightStampSpan(stamp, row, nXPos + x, nYPos, 0, min_y);
+		} else if (x == 0) {
+			if (max_y >= 0)
+				LightStampSpan(stamp, row, nXPos, nYPos, -max_x, -1);
+			if (min_y >= 0)
+				LightStampSpan(stamp, row, nXPos, nYPos, 1, min_x);
+		} else {
+			if (x >= -min_x)
+				LightStampSpan(stamp, row, nXPos + x, nYPos, -max_y, 0);
+			if (x >= -min_y)
+				LightStampSpan(stamp, row, nXPos + x, nYPos, 1, min_x);
 		}
 	}
 }
@@ -965,6 +1128,14 @@ void MakeLightTable()
 			}
 		}
 	}
+
+	for (k = 0; k < 16; k++) {
+		for (l = 0; l < 64; l++) {
+			lightstamps[k][l].valid = FALSE;
+		}
+	}
+
+	ClearTileCache();
 }
 
 #ifdef _DEBUG
@@ -1003,6 +1174,7 @@ void InitLighting()
 	numlights = 0;
 	dolighting = FALSE;
 	lightflag = FALSE;
+	sgbLightRegionsValid = FALSE;
 
 	for (i = 0; i < MAXLIGHTS; i++) {
 		lightactive[i] = i;
@@ -1104,30 +1276,231 @@ void ChangeLight(int i, int x, int y, int r)
 	dolighting = TRUE;
 }
 
+static void InitIncrementalLighting()
+{
+	int mode;
+
+	sgbLightIncrInit = TRUE;
+	mode = 0;
+	if (!SRegLoadValue("devilutionx", "Incremental Lighting", 0, &mode))
+		SRegSaveValue("devilutionx", "Incremental Lighting", 0, mode);
+	sgnLightIncremental = mode;
+}
+
+/**
+ * @brief record where light Lnum is stamped now and add it to the masks of the regions it touches
+ */
+static void AddLightFootprint(int Lnum)
+{
+	LightFootprint *fp;
+	LightStamp *stamp;
+	int x, y, xoff, yoff, rx, ry;
+
+	fp = &sgLightFootprints[Lnum];
+	fp->stamped = TRUE;
+	fp->x = LightList[Lnum]._lx;
+	fp->y = LightList[Lnum]._ly;
+	fp->r = LightList[Lnum]._lradius;
+	fp->xoff = LightList[Lnum]._xoff;
+	fp->yoff = LightList[Lnum]._yoff;
+
+	// same adjustment as DoLighting
+	x = fp->x;
+	y = fp->y;
+	xoff = fp->xoff;
+	yoff = fp->yoff;
+	if (xoff < 0) {
+		xoff += 8;
+		x--;
+	}
+	if (yoff < 0) {
+		yoff += 8;
+		y--;
+	}
+	stamp = &lightstamps[fp->r][xoff + 8 * yoff];
+	if (!stamp->valid)
+		MakeLightStamp(stamp, fp->r, xoff, yoff);
+
+	fp->rx0 = x + stamp->x0;
+	fp->ry0 = y + stamp->y0;
+	fp->rx1 = x + stamp->x1;
+	fp->ry1 = y + stamp->y1;
+	if (fp->rx0 < 0)
+		fp->rx0 = 0;
+	if (fp->ry0 < 0)
+		fp->ry0 = 0;
+	if (fp->rx1 > MAXDUNX - 1)
+		fp->rx1 = MAXDUNX - 1;
+	if (fp->ry1 > MAXDUNY - 1)
+		fp->ry1 = MAXDUNY - 1;
+	fp->rx0 >>= LIGHT_REGION_SHIFT;
+	fp->ry0 >>= LIGHT_REGION_SHIFT;
+	fp->rx1 >>= LIGHT_REGION_SHIFT;
+	fp->ry1 >>= LIGHT_REGION_SHIFT;
+	for (rx = fp->rx0; rx <= fp->rx1; rx++) {
+		for (ry = fp->ry0; ry <= fp->ry1; ry++) {
+			sgdwLightRegionMask[rx][ry] |= 1u << Lnum;
+		}
+	}
+}
+
+/**
+ * @brief take light Lnum out of the region masks, marking the regions it lit as dirty
+ */
+static void RemoveLightFootprint(int Lnum, BOOLEAN (*dirty)[LIGHT_REGIONS_Y])
+{
+	LightFootprint *fp;
+	int rx, ry;
+
+	fp = &sgLightFootprints[Lnum];
+	for (rx = fp->rx0; rx <= fp->rx1; rx++) {
+		for (ry = fp->ry0; ry <= fp->ry1; ry++) {
+			sgdwLightRegionMask[rx][ry] &= ~(1u << Lnum);
+			dirty[rx][ry] = TRUE;
+		}
+	}
+	fp->stamped = FALSE;
+}
+
+/**
+ * @brief rebuild dLight from dPreLight and every light that is not being deleted
+ */
+static void RecomputeLightMap()
+{
+	int i, j;
+
+	memcpy(dLight, dPreLight, sizeof(dLight));
+	for (i = 0; i < numlights; i++) {
+		j = lightactive[i];
+		if (!LightList[j]._ldel) {
+			DoLighting(LightList[j]._lx, LightList[j]._ly, LightList[j]._lradius, j);
+		}
+	}
+}
+
+/**
+ * @brief bring dLight up to date by only recomputing the regions whose lights changed
+ *
+ * Unlike DoUnLight this resets the whole area a light touched, so the result
+ * always equals RecomputeLightMap.
+ */
+static void ProcessLightRegions()
+{
+	BOOLEAN active[MAXLIGHTS];
+	BOOLEAN dirty[LIGHT_REGIONS_X][LIGHT_REGIONS_Y];
+	LightFootprint *fp;
+	LightListStruct *pLight;
+	DWORD relight;
+	int i, j, rx, ry, x;
+
+	if (!sgbLightRegionsValid || memcmp(sgLightShadow, dLight, sizeof(dLight)) != 0) {
+		// someone else rewrote the light map, start over
+		memset(sgdwLightRegionMask, 0, sizeof(sgdwLightRegionMask));
+		for (i = 0; i < MAXLIGHTS; i++) {
+			sgLightFootprints[i].stamped = FALSE;
+		}
+		RecomputeLightMap();
+		for (i = 0; i < numlights; i++) {
+			j = lightactive[i];
+			LightList[j]._lunflag = 0;
+			if (!LightList[j]._ldel)
+				AddLightFootprint(j);
+		}
+		sgbLightRegionsValid = TRUE;
+		return;
+	}
+
+	memset(active, FALSE, sizeof(active));
+	memset(dirty, FALSE, sizeof(dirty));
+	for (i = 0; i < numlights; i++) {
+		j = lightactive[i];
+		pLight = &LightList[j];
+		fp = &sgLightFootprints[j];
+		pLight->_lunflag = 0;
+		if (pLight->_ldel)
+			continue;
+		active[j] = TRUE;
+		if (fp->stamped && fp->x == pLight->_lx && fp->y == pLight->_ly && fp->r == pLight->_lradius
+		    && fp->xoff == pLight->_xoff && fp->yoff == pLight->_yoff)
+			continue;
+		if (fp->stamped)
+			RemoveLightFootprint(j, dirty);
+		AddLightFootprint(j);
+		for (rx = fp->rx0; rx <= fp->rx1; rx++) {
+			for (ry = fp->ry0; ry <= fp->ry1; ry++) {
+				dirty[rx][ry] = TRUE;
+			}
+		}
+	}
+	for (j = 0; j < MAXLIGHTS; j++) {
+		if (sgLightFootprints[j].stamped && !active[j])
+			RemoveLightFootprint(j, dirty);
+	}
+
+	relight = 0;
+	for (rx = 0; rx < LIGHT_REGIONS_X; rx++) {
+		for (ry = 0; ry < LIGHT_REGIONS_Y; ry++) {
+			if (!dirty[rx][ry])
+				continue;
+			relight |= sgdwLightRegionMask[rx][ry];
+			for (x = rx << LIGHT_REGION_SHIFT; x < (rx + 1) << LIGHT_REGION_SHIFT; x++) {
+				memcpy(&dLight[x][ry << LIGHT_REGION_SHIFT], &dPreLight[x][ry << LIGHT_REGION_SHIFT], 1 << LIGHT_REGION_SHIFT);
+			}
+		}
+	}
+
+	// stamping a whole light is fine, outside the dirty regions it is already part of dLight
+	for (j = 0; j < MAXLIGHTS; j++) {
+		if (relight & (1u << j))
+			DoLighting(LightList[j]._lx, LightList[j]._ly, LightList[j]._lradius, j);
+	}
+}
+
 void ProcessLightList()
 {
 	int i, j;
 	BYTE temp;
+	char *pVerify;
 
 	if (lightflag) {
 		return;
 	}
 
+	if (!sgbLightIncrInit)
+		InitIncrementalLighting();
+
 	if (dolighting) {
-		for (i = 0; i < numlights; i++) {
-			j = lightactive[i];
-			if (LightList[j]._ldel) {
-				DoUnLight(LightList[j]._lx, LightList[j]._ly, LightList[j]._lradius);
+		if (sgnLightIncremental != 0) {
+			ProcessLightRegions();
+			if (sgnLightIncremental == 2) {
+				pVerify = (char *)DiabloAllocPtr(sizeof(dLight));
+				memcpy(pVerify, dLight, sizeof(dLight));
+				RecomputeLightMap();
+				if (memcmp(pVerify, dLight, sizeof(dLight)) != 0) {
+					for (i = 0; pVerify[i] == ((char *)dLight)[i]; i++)
+						;
+					app_fatal("ProcessLightList: incremental light differs at %d,%d", i / MAXDUNY, i % MAXDUNY);
+				}
+				mem_free_dbg(pVerify);
 			}
-			if (LightList[j]._lunflag) {
-				DoUnLight(LightList[j]._lunx, LightList[j]._luny, LightList[j]._lunr);
-				LightList[j]._lunflag = 0;
+			memcpy(sgLightShadow, dLight, sizeof(dLight));
+		} else {
+			sgbLightRegionsValid = FALSE;
+			for (i = 0; i < numlights; i++) {
+				j = lightactive[i];
+				if (LightList[j]._ldel) {
+					DoUnLight(LightList[j]._lx, LightList[j]._ly, LightList[j]._lradius);
+				}
+				if (LightList[j]._lunflag) {
+					DoUnLight(LightList[j]._lunx, LightList[j]._luny, LightList[j]._lunr);
+					LightList[j]._lunflag = 0;
+				}
 			}
-		}
-		for (i = 0; i < numlights; i++) {
-			j = lightactive[i];
-			if (!LightList[j]._ldel) {
-				DoLighting(LightList[j]._lx, LightList[j]._ly, LightList[j]._lradius, j);
+			for (i = 0; i < numlights; i++) {
+				j = lightactive[i];
+				if (!LightList[j]._ldel) {
+					DoLighting(LightList[j]._lx, LightList[j]._ly, LightList[j]._lradius, j);
+				}
 			}
 		}
 		i = 0;
@@ -1149,6 +1522,7 @@ void ProcessLightList()
 void SavePreLighting()
 {
 	memcpy(dPreLight, dLight, sizeof(dPreLight));
+	sgbLightRegionsValid = FALSE;
 }
 
 void InitVision()
@@ -1286,6 +1660,8 @@ void lighting_color_cycling()
 		*tbl++ = col;
 		tbl += 224;
 	}
+
+	ClearTileCache();
 }
 
 DEVILUTION_END_NAMESPACE
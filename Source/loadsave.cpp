@@ -71,6 +71,11 @@ void LoadGame(BOOL firstflag)
 			missileavail[i] = BLoad();
 		for (i = 0; i < nummissiles; i++)
 			LoadMissile(missileactive[i]);
+		numfirewalls = 0;
+		for (i = 0; i < nummissiles; i++) {
+			if (missile[missileactive[i]]._mitype == MIS_FIREWALL)
+				numfirewalls++;
+		}
 		for (i = 0; i < MAXOBJECTS; i++)
 			objectactive[i] = BLoad();
 		for (i = 0; i < MAXOBJECTS; i++)
@@ -933,7 +938,6 @@ void SaveGame()
 	pfile_get_game_name(szName);
 	dwLen = codec_get_encoded_len(tbuff - SaveBuff);
 	pfile_write_save_file(szName, SaveBuff, tbuff - SaveBuff, dwLen);
-	mem_free_dbg(SaveBuff);
 	gbValidSaveFile = TRUE;
 	pfile_rename_temp_to_perm();
 	pfile_write_hero();
@@ -1598,7 +1602,6 @@ void SaveLevel()
 	GetTempLevelNames(szName);
 	dwLen = codec_get_encoded_len(tbuff - SaveBuff);
 	pfile_write_save_file(szName, SaveBuff, tbuff - SaveBuff, dwLen);
-	mem_free_dbg(SaveBuff);
 
 	if (!setlevel)
 		plr[myplr]._pLvlVisited[currlevel] = TRUE;
@@ -6,6 +6,8 @@ int missileactive[MAXMISSILES];
 int missileavail[MAXMISSILES];
 MissileStruct missile[MAXMISSILES];
 int nummissiles;
+/** Active MIS_FIREWALL missiles, lets PosOkMonst tell if there are any without a scan */
+int numfirewalls;
 BOOL ManashieldFlag;
 ChainStruct chain[MAXMISSILES];
 BOOL MissilePreFlag;
@@ -355,6 +357,8 @@ void DeleteMissile(int mi, int i)
 			NetSendCmd(TRUE, CMD_REMSHIELD);
 		plr[src].pManaShield = FALSE;
 	}
+	if (missile[mi]._mitype == MIS_FIREWALL)
+		numfirewalls--;
 	missileavail[MAXMISSILES - nummissiles] = mi;
 	nummissiles--;
 	if (nummissiles > 0 && i != nummissiles)
@@ -1094,18 +1098,18 @@ void LoadMissileGFX(BYTE mi)
 	mfd = &misfiledata[mi];
 	if (mfd->mFlags & MFLAG_ALLOW_SPECIAL) {
 		sprintf(pszName, "Missiles\\%s.CL2", mfd->mName);
-		file = LoadFileInMem(pszName, NULL);
+		file = LoadFileView(pszName, NULL);
 		for (i = 0; i < mfd->mAnimFAmt; i++)
 			mfd->mAnimData[i] = CelGetFrameStart(file, i);
 	} else if (mfd->mAnimFAmt == 1) {
 		sprintf(pszName, "Missiles\\%s.CL2", mfd->mName);
 		if (!mfd->mAnimData[0])
-			mfd->mAnimData[0] = LoadFileInMem(pszName, NULL);
+			mfd->mAnimData[0] = LoadFileView(pszName, NULL);
 	} else {
 		for (i = 0; i < mfd->mAnimFAmt; i++) {
 			sprintf(pszName, "Missiles\\%s%i.CL2", mfd->mName, i + 1);
 			if (!mfd->mAnimData[i]) {
-				file = LoadFileInMem(pszName, NULL);
+				file = LoadFileView(pszName, NULL);
 				mfd->mAnimData[i] = file;
 			}
 		}
@@ -1130,7 +1134,7 @@ void FreeMissileGFX(int mi)
 	if (misfiledata[mi].mFlags & MFLAG_ALLOW_SPECIAL) {
 		if (misfiledata[mi].mAnimData[0]) {
 			pFrameTable = (DWORD *)misfiledata[mi].mAnimData[0];
-			mem_free_dbg(&pFrameTable[-misfiledata[mi].mAnimFAmt]); // TODO find a cleaner way to access the offeset
+			ReleaseFileView((BYTE *)&pFrameTable[-misfiledata[mi].mAnimFAmt]); // TODO find a cleaner way to access the offeset
 			misfiledata[mi].mAnimData[0] = NULL;
 		}
 		return;
@@ -1140,7 +1144,7 @@ void FreeMissileGFX(int mi)
 		if (misfiledata[mi].mAnimData[i]) {
 			pFrameTable = (DWORD *)misfiledata[mi].mAnimData[i];
 			misfiledata[mi].mAnimData[i] = NULL;
-			mem_free_dbg(pFrameTable);
+			ReleaseFileView((BYTE *)pFrameTable);
 		}
 	}
 }
@@ -1181,6 +1185,7 @@ void InitMissiles()
 		}
 	}
 	nummissiles = 0;
+	numfirewalls = 0;
 	for (i = 0; i < MAXMISSILES; i++) {
 		missileavail[i] = i;
 		missileactive[i] = 0;
@@ -2437,6 +2442,8 @@ int AddMissile(int sx, int sy, int dx, int dy, int midir, int mitype, char micas
 	nummissiles++;
 
 	missile[mi]._mitype = mitype;
+	if (mitype == MIS_FIREWALL)
+		numfirewalls++;
 	missile[mi]._micaster = micaster;
 	missile[mi]._misource = id;
 	missile[mi]._miAnimType = missiledata[mitype].mFileNum;
@@ -4031,8 +4038,8 @@ void ProcessMissiles()
 	i = 0;
 	while (i < nummissiles) {
 		if (missile[missileactive[i]]._miDelFlag) {
+			// the last missile moves in here, the ones before were already checked
 			DeleteMissile(missileactive[i], i);
-			i = 0;
 		} else {
 			i++;
 		}
@@ -4068,8 +4075,8 @@ void ProcessMissiles()
 	i = 0;
 	while (i < nummissiles) {
 		if (missile[missileactive[i]]._miDelFlag) {
+			// the last missile moves in here, the ones before were already checked
 			DeleteMissile(missileactive[i], i);
-			i = 0;
 		} else {
 			i++;
 		}
@@ -6,6 +6,7 @@ extern int missileactive[MAXMISSILES];
 extern int missileavail[MAXMISSILES];
 extern MissileStruct missile[MAXMISSILES];
 extern int nummissiles;
+extern int numfirewalls;
 extern BOOL ManashieldFlag;
 extern ChainStruct chain[MAXMISSILES];
 extern BOOL MissilePreFlag;
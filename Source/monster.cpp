@@ -18,6 +18,9 @@ CMonster Monsters[16];
 int monstimgtot;
 int uniquetrans;
 int nummtypes;
+static BOOL sgbFlowFieldInit;
+// monsters take their steps from flow fields shared per target instead of running FindPath each
+static BOOL sgbFlowFieldPathing;
 
 const char plr2monst[9] = { 0, 5, 3, 7, 1, 4, 6, 0, 2 };
 const BYTE counsmiss[4] = { MIS_FIREBOLT, MIS_CBOLT, MIS_LIGHTCTRL, MIS_FIREBALL };
@@ -280,7 +283,8 @@ void InitMonsterGFX(int monst)
 {
 	int mtype, anim, i;
 	char strBuff[256];
-	BYTE *celBuf;
+	BYTE *celBuf, *view;
+	DWORD len;
 
 	mtype = Monsters[monst].mtype;
 
@@ -288,7 +292,14 @@ void InitMonsterGFX(int monst)
 		if ((animletter[anim] != 's' || monsterdata[mtype].has_special) && monsterdata[mtype].Frames[anim] > 0) {
 			sprintf(strBuff, monsterdata[mtype].GraphicType, animletter[anim]);
 
-			celBuf = LoadFileInMem(strBuff, NULL);
+			celBuf = LoadFileView(strBuff, &len);
+			// color translations are applied in place, those need a private copy
+			if (monsterdata[mtype].has_trans) {
+				view = celBuf;
+				celBuf = DiabloAllocPtr(len);
+				memcpy(celBuf, view, len);
+				ReleaseFileView(view);
+			}
 			Monsters[monst].Anims[anim].CMem = celBuf;
 
 			if (Monsters[monst].mtype != MT_GOLEM || (animletter[anim] != 's' && animletter[anim] != 'd')) {
@@ -1118,7 +1129,7 @@ BOOL M_Talker(int i)
 
 void M_Enemy(int i)
 {
-	int j;
+	int j, candidates;
 	int mi, pnum;
 	int dist, best_dist;
 	int _menemy;
@@ -1155,7 +1166,13 @@ void M_Enemy(int i)
 			}
 		}
 	}
-	for (j = 0; j < nummonsters; j++) {
+	// Other monsters only ever target golems. Golems only live in the first
+	// MAX_PLRS monster slots, which take the first MAX_PLRS places in
+	// monstactive and are never swapped out by DeleteMonster.
+	candidates = nummonsters;
+	if (!(Monst->_mFlags & MFLAG_GOLEM) && candidates > MAX_PLRS)
+		candidates = MAX_PLRS;
+	for (j = 0; j < candidates; j++) {
 		mi = monstactive[j];
 		if (mi == i)
 			continue;
@@ -2822,6 +2839,8 @@ BOOL M_PathWalk(int i)
 	char path[25];
 	BOOL(*Check)
 	(int, int, int);
+	BOOL fire;
+	int len;
 
 	if ((DWORD)i >= MAXMONSTERS)
 		app_fatal("M_PathWalk: Invalid monster %d", i);
@@ -2830,7 +2849,15 @@ BOOL M_PathWalk(int i)
 	if (!(monster[i]._mFlags & MFLAG_CAN_OPEN_DOOR))
 		Check = PosOkMonst;
 
-	if (FindPath(Check, i, monster[i]._mx, monster[i]._my, monster[i]._menemyx, monster[i]._menemyy, path)) {
+	// monsters take different steps than with FindPath, which would desync multiplayer games
+	if (sgbFlowFieldPathing && gbMaxPlayers == 1) {
+		// the only part of Check that depends on the monster is whether fire walls block it
+		fire = !(monster[i].mMagicRes & IMUNE_FIRE) || monster[i].MType->mtype == MT_DIABLO;
+		len = FindPathFlow(Check, i, fire, monster[i]._mx, monster[i]._my, monster[i]._menemyx, monster[i]._menemyy, path);
+	} else {
+		len = FindPath(Check, i, monster[i]._mx, monster[i]._my, monster[i]._menemyx, monster[i]._menemyy, path);
+	}
+	if (len) {
 		M_CallWalk(i, plr2monst[path[0]]); /* plr2monst is local */
 		return TRUE;
 	}
@@ -4507,14 +4534,25 @@ void DeleteMonsterList()
 	i = MAX_PLRS;
 	while (i < nummonsters) {
 		if (monster[monstactive[i]]._mDelFlag) {
+			// the last monster moves in here, the ones before were already checked
 			DeleteMonster(i);
-			i = 0; // TODO: check if this should be MAX_PLRS.
 		} else {
 			i++;
 		}
 	}
 }
 
+static void InitFlowFieldPathing()
+{
+	int enabled;
+
+	sgbFlowFieldInit = TRUE;
+	enabled = 0;
+	if (!SRegLoadValue("devilutionx", "Flow Field Pathing", 0, &enabled))
+		SRegSaveValue("devilutionx", "Flow Field Pathing", 0, enabled);
+	sgbFlowFieldPathing = enabled;
+}
+
 void ProcessMonsters()
 {
 	int i, mi, mx, my, _menemy;
@@ -4523,6 +4561,11 @@ void ProcessMonsters()
 
 	DeleteMonsterList();
 
+	if (!sgbFlowFieldInit)
+		InitFlowFieldPathing();
+	if (sgbFlowFieldPathing)
+		ClearFlowFields();
+
 	assert((DWORD)nummonsters <= MAXMONSTERS);
 	for (i = 0; i < nummonsters; i++) {
 		mi = monstactive[i];
@@ -4667,7 +4710,11 @@ void FreeMonsters()
 		mtype = Monsters[i].mtype;
 		for (j = 0; j < 6; j++) {
 			if (animletter[j] != 's' || monsterdata[mtype].has_special) {
-				MemFreeDbg(Monsters[i].Anims[j].CMem);
+				if (monsterdata[mtype].has_trans) {
+					MemFreeDbg(Monsters[i].Anims[j].CMem);
+				} else {
+					MemFreeView(Monsters[i].Anims[j].CMem);
+				}
 			}
 		}
 	}
@@ -5188,7 +5235,7 @@ void MissToMonst(int i, int x, int y)
 
 BOOL PosOkMonst(int i, int x, int y)
 {
-	int oi, mi, j;
+	int oi, mi;
 	BOOL ret, fire;
 
 	fire = FALSE;
@@ -5202,13 +5249,9 @@ BOOL PosOkMonst(int i, int x, int y)
 	if (ret && dMissile[x][y] && i >= 0) {
 		mi = dMissile[x][y];
 		if (mi > 0) {
-			if (missile[mi - 1]._mitype == MIS_FIREWALL) { // BUGFIX: Change 'mi' to 'mi - 1' (fixed)
+			// any firewall on the level counts, not just one on this tile
+			if (missile[mi - 1]._mitype == MIS_FIREWALL || numfirewalls != 0) { // BUGFIX: Change 'mi' to 'mi - 1' (fixed)
 				fire = TRUE;
-			} else {
-				for (j = 0; j < nummissiles; j++) {
-					if (missile[missileactive[j]]._mitype == MIS_FIREWALL)
-						fire = TRUE;
-				}
 			}
 		}
 		if (fire && (!(monster[i].mMagicRes & IMUNE_FIRE) || monster[i].MType->mtype == MT_DIABLO))
@@ -5220,7 +5263,7 @@ BOOL PosOkMonst(int i, int x, int y)
 
 BOOL PosOkMonst2(int i, int x, int y)
 {
-	int oi, mi, j;
+	int oi, mi;
 	BOOL ret, fire;
 
 	fire = FALSE;
@@ -5234,13 +5277,9 @@ BOOL PosOkMonst2(int i, int x, int y)
 	if (ret && dMissile[x][y] && i >= 0) {
 		mi = dMissile[x][y];
 		if (mi > 0) {
-			if (missile[mi - 1]._mitype == MIS_FIREWALL) { // BUGFIX: Change 'mi' to 'mi - 1' (fixed)
+			// any firewall on the level counts, not just one on this tile
+			if (missile[mi - 1]._mitype == MIS_FIREWALL || numfirewalls != 0) { // BUGFIX: Change 'mi' to 'mi - 1' (fixed)
 				fire = TRUE;
-			} else {
-				for (j = 0; j < nummissiles; j++) {
-					if (missile[missileactive[j]]._mitype == MIS_FIREWALL)
-						fire = TRUE;
-				}
 			}
 		}
 		if (fire && (!(monster[i].mMagicRes & IMUNE_FIRE) || monster[i].MType->mtype == MT_DIABLO))
@@ -5252,7 +5291,7 @@ BOOL PosOkMonst2(int i, int x, int y)
 
 BOOL PosOkMonst3(int i, int x, int y)
 {
-	int j, oi, objtype, mi;
+	int oi, objtype, mi;
 	BOOL ret, fire, isdoor;
 
 	fire = FALSE;
@@ -5275,15 +5314,9 @@ BOOL PosOkMonst3(int i, int x, int y)
 	if (ret && dMissile[x][y] != 0 && i >= 0) {
 		mi = dMissile[x][y];
 		if (mi > 0) {
-			if (missile[mi - 1]._mitype == MIS_FIREWALL) { // BUGFIX: Change 'mi' to 'mi - 1' (fixed)
+			// any firewall on the level counts, not just one on this tile
+			if (missile[mi - 1]._mitype == MIS_FIREWALL || numfirewalls != 0) { // BUGFIX: Change 'mi' to 'mi - 1' (fixed)
 				fire = TRUE;
-			} else {
-				for (j = 0; j < nummissiles; j++) {
-					mi = missileactive[j];
-					if (missile[mi]._mitype == MIS_FIREWALL) {
-						fire = TRUE;
-					}
-				}
 			}
 		}
 		if (fire && (!(monster[i].mMagicRes & IMUNE_FIRE) || monster[i].MType->mtype == MT_DIABLO)) {
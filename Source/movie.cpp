@@ -17,6 +17,7 @@ void play_movie(char *pszMovie, BOOL user_can_close)
 	}
 #endif
 
+	dx_present_stop();
 	saveProc = SetWindowProc(MovieWndProc);
 	movie_playing = TRUE;
 	sound_disable_music(TRUE);
@@ -12,6 +12,22 @@ BOOLEAN save_archive_open;
 
 //note: 32872 = 32768 + 104 (sizeof(_FILEHEADER))
 
+// header, block table and hash table, which sit back to back at the start of the archive
+#define MPQ_TABLES_SIZE (104 + 0x8000 + 0x8000)
+
+/** Space released since the archive was opened, kept out of reuse until the new tables are on disk */
+typedef struct FreedBlock {
+	int offset;
+	int size;
+} FreedBlock;
+
+static FreedBlock sgFreedBlocks[2048];
+static int sgnFreedBlocks;
+/** Path of the open archive, for writing its tables before it is closed */
+static char sgszMpqArchive[MAX_PATH];
+/** The open archive is a multiplayer save, the save thread can't go by gbMaxPlayers */
+static BOOLEAN sgbMpqMulti;
+
 /* data */
 
 HANDLE sghArchive = INVALID_HANDLE_VALUE;
@@ -37,7 +53,7 @@ void mpqapi_store_creation_time(const char *pszArchive, DWORD dwChar)
 	struct _WIN32_FIND_DATAA FindFileData;
 	char dst[160];
 
-	if (gbMaxPlayers != 1) {
+	if (sgbMpqMulti) {
 		mpqapi_reg_load_modification_time(dst, 160);
 		handle = FindFirstFile(pszArchive, &FindFileData);
 		if (handle != INVALID_HANDLE_VALUE) {
@@ -133,6 +149,31 @@ BOOLEAN mpqapi_reg_store_modification_time(char *pbData, DWORD dwLen)
 #endif
 }
 
+/**
+ * @brief Hand the space freed since the archive was opened over to the free list
+ */
+static void mpqapi_release_blocks()
+{
+	int i;
+
+	for (i = 0; i < sgnFreedBlocks; i++)
+		mpqapi_alloc_block(sgFreedBlocks[i].offset, sgFreedBlocks[i].size);
+	sgnFreedBlocks = 0;
+}
+
+/**
+ * @brief Put the tables on disk early so the space held back in sgFreedBlocks can be reused
+ *
+ * Only called between archive operations, when the tables point at nothing
+ * half written.
+ */
+static void mpqapi_flush_freed_blocks()
+{
+	if (!mpqapi_write_tables(sgszMpqArchive))
+		app_fatal("Unable to write the tables of %s", sgszMpqArchive);
+	mpqapi_release_blocks();
+}
+
 void mpqapi_remove_hash_entry(const char *pszName)
 {
 	_HASHENTRY *pHashTbl;
@@ -141,13 +182,18 @@ void mpqapi_remove_hash_entry(const char *pszName)
 
 	hIdx = FetchHandle(pszName);
 	if (hIdx != -1) {
+		if (sgnFreedBlocks == 2048)
+			mpqapi_flush_freed_blocks();
 		pHashTbl = &sgpHashTbl[hIdx];
 		blockEntry = &sgpBlockTbl[pHashTbl->block];
 		pHashTbl->block = -2;
 		block_offset = blockEntry->offset;
 		block_size = blockEntry->sizealloc;
 		memset(blockEntry, 0, sizeof(*blockEntry));
-		mpqapi_alloc_block(block_offset, block_size);
+		// the tables on disk may still point here, so new data must not land on it yet
+		sgFreedBlocks[sgnFreedBlocks].offset = block_offset;
+		sgFreedBlocks[sgnFreedBlocks].size = block_size;
+		sgnFreedBlocks++;
 		save_archive_modified = 1;
 	}
 }
@@ -248,6 +294,9 @@ BOOL mpqapi_write_file(const char *pszName, const BYTE *pbData, DWORD dwLen)
 {
 	_BLOCKENTRY *blockEntry;
 
+	// both removes below may hold back a block, make room while the tables are still consistent
+	if (sgnFreedBlocks >= 2048 - 2)
+		mpqapi_flush_freed_blocks();
 	save_archive_modified = TRUE;
 	mpqapi_remove_hash_entry(pszName);
 	blockEntry = mpqapi_add_file(pszName, 0, 0);
@@ -427,7 +476,7 @@ BOOL mpqapi_has_file(const char *pszName)
 	return FetchHandle(pszName) != -1;
 }
 
-BOOL OpenMPQ(const char *pszArchive, BOOL hidden, DWORD dwChar)
+BOOL OpenMPQ(const char *pszArchive, BOOL hidden, BOOL is_single_player, DWORD dwChar)
 {
 	DWORD dwFlagsAndAttributes;
 	DWORD key;
@@ -435,10 +484,12 @@ BOOL OpenMPQ(const char *pszArchive, BOOL hidden, DWORD dwChar)
 	_FILEHEADER fhdr;
 
 	InitHash();
+	SStrCopy(sgszMpqArchive, pszArchive, sizeof(sgszMpqArchive));
 	if (!mpqapi_set_hidden(pszArchive, hidden)) {
 		return FALSE;
 	}
-	dwFlagsAndAttributes = gbMaxPlayers > 1 ? FILE_FLAG_WRITE_THROUGH : 0;
+	sgbMpqMulti = !is_single_player;
+	dwFlagsAndAttributes = sgbMpqMulti ? FILE_FLAG_WRITE_THROUGH : 0;
 	save_archive_open = FALSE;
 	sghArchive = CreateFile(pszArchive, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, dwFlagsAndAttributes, NULL);
 	if (sghArchive == INVALID_HANDLE_VALUE) {
@@ -448,6 +499,9 @@ BOOL OpenMPQ(const char *pszArchive, BOOL hidden, DWORD dwChar)
 		save_archive_open = TRUE;
 		save_archive_modified = TRUE;
 	}
+	if (!mpqapi_replay_tables(pszArchive)) {
+		goto on_error;
+	}
 	if (sgpBlockTbl == NULL || sgpHashTbl == NULL) {
 		memset(&fhdr, 0, sizeof(fhdr));
 		if (ParseMPQHeader(&fhdr, &sgdwMpqOffset) == FALSE) {
@@ -489,6 +543,7 @@ BOOL ParseMPQHeader(_FILEHEADER *pHdr, DWORD *pdwNextFileStart)
 	size = GetFileSize(sghArchive, 0);
 	*pdwNextFileStart = size;
 
+	// a save interrupted before its tables were written leaves unused data past filesize
 	if (size == -1
 	    || size < sizeof(*pHdr)
 	    || !ReadFile(sghArchive, pHdr, sizeof(*pHdr), &NumberOfBytesRead, NULL)
@@ -497,7 +552,8 @@ BOOL ParseMPQHeader(_FILEHEADER *pHdr, DWORD *pdwNextFileStart)
 	    || pHdr->headersize != 32
 	    || pHdr->version > 0
 	    || pHdr->sectorsizeid != 3
-	    || pHdr->filesize != size
+	    || pHdr->filesize > size
+	    || pHdr->filesize < MPQ_TABLES_SIZE
 	    || pHdr->hashoffset != 32872
 	    || pHdr->blockoffset != 104
 	    || pHdr->hashcount != 2048
@@ -516,6 +572,8 @@ BOOL ParseMPQHeader(_FILEHEADER *pHdr, DWORD *pdwNextFileStart)
 		*pdwNextFileStart = 0x10068;
 		save_archive_modified = TRUE;
 		save_archive_open = 1;
+	} else {
+		*pdwNextFileStart = pHdr->filesize;
 	}
 
 	return TRUE;
@@ -526,6 +584,9 @@ void CloseMPQ(const char *pszArchive, BOOL bFree, DWORD dwChar)
 	if (bFree) {
 		MemFreeDbg(sgpBlockTbl);
 		MemFreeDbg(sgpHashTbl);
+		sgnFreedBlocks = 0;
+	} else {
+		mpqapi_release_blocks();
 	}
 	if (sghArchive != INVALID_HANDLE_VALUE) {
 		CloseHandle(sghArchive);
@@ -547,7 +608,7 @@ void mpqapi_store_modified_time(const char *pszArchive, DWORD dwChar)
 	struct _WIN32_FIND_DATAA FindFileData;
 	char dst[160];
 
-	if (gbMaxPlayers != 1) {
+	if (sgbMpqMulti) {
 		mpqapi_reg_load_modification_time(dst, 160);
 		handle = FindFirstFile(pszArchive, &FindFileData);
 		if (handle != INVALID_HANDLE_VALUE) {
@@ -565,69 +626,147 @@ BOOL mpqapi_flush_and_close(const char *pszArchive, BOOL bFree, DWORD dwChar)
 		ret = TRUE;
 	else {
 		ret = FALSE;
+		mpqapi_release_blocks();
 		if (!save_archive_modified)
 			ret = TRUE;
-		else if (mpqapi_can_seek() && WriteMPQHeader() && mpqapi_write_block_table()) {
-			if (mpqapi_write_hash_table())
-				ret = TRUE;
-			else
-				ret = FALSE;
-		}
+		else if (mpqapi_write_tables(pszArchive) && mpqapi_can_seek())
+			ret = TRUE;
+		// closing flushes anything still buffered
+		if (!CloseHandle(sghArchive))
+			ret = FALSE;
+		sghArchive = INVALID_HANDLE_VALUE;
 	}
 	CloseMPQ(pszArchive, bFree, dwChar);
 	return ret;
 }
 
-BOOL WriteMPQHeader()
+static void mpqapi_journal_name(char *dst, const char *pszArchive)
 {
-	_FILEHEADER fhdr;
-	DWORD NumberOfBytesWritten;
-
-	memset(&fhdr, 0, sizeof(fhdr));
-	fhdr.signature = SDL_SwapLE32('\x1AQPM');
-	fhdr.headersize = SDL_SwapLE32(32);
-	fhdr.filesize = SDL_SwapLE32(GetFileSize(sghArchive, 0));
-	fhdr.version = SDL_SwapLE16(0);
-	fhdr.sectorsizeid = SDL_SwapLE16(3);
-	fhdr.hashoffset = SDL_SwapLE32(32872);
-	fhdr.blockoffset = SDL_SwapLE32(104);
-	fhdr.hashcount = SDL_SwapLE32(2048);
-	fhdr.blockcount = SDL_SwapLE32(2048);
-
-	if (SetFilePointer(sghArchive, 0, NULL, FILE_BEGIN) == -1)
-		return 0;
-	if (!WriteFile(sghArchive, &fhdr, sizeof(fhdr), &NumberOfBytesWritten, 0))
-		return 0;
-
-	return NumberOfBytesWritten == 104;
+	snprintf(dst, MAX_PATH, "%s.tbl", pszArchive);
 }
 
-BOOL mpqapi_write_block_table()
+static DWORD mpqapi_checksum(const BYTE *pbData, DWORD dwLen)
 {
-	BOOL success;
-	DWORD NumberOfBytesWritten;
+	DWORD sum = 2166136261u;
 
-	if (SetFilePointer(sghArchive, 104, NULL, FILE_BEGIN) == -1)
-		return FALSE;
+	while (dwLen--)
+		sum = (sum ^ *pbData++) * 16777619u;
+	return sum;
+}
 
-	Encrypt(sgpBlockTbl, 0x8000, Hash("(block table)", 3));
-	success = WriteFile(sghArchive, sgpBlockTbl, 0x8000, &NumberOfBytesWritten, 0);
-	Decrypt(sgpBlockTbl, 0x8000, Hash("(block table)", 3));
-	return success && NumberOfBytesWritten == 0x8000;
+/**
+ * @brief Build the header and the encrypted tables as they are laid out on disk
+ * @param pbImage MPQ_TABLES_SIZE bytes, followed by room for a checksum
+ */
+static void mpqapi_build_tables(BYTE *pbImage)
+{
+	_FILEHEADER *fhdr;
+
+	fhdr = (_FILEHEADER *)pbImage;
+	memset(fhdr, 0, sizeof(*fhdr));
+	fhdr->signature = SDL_SwapLE32('\x1AQPM');
+	fhdr->headersize = SDL_SwapLE32(32);
+	fhdr->filesize = SDL_SwapLE32(sgdwMpqOffset);
+	fhdr->version = SDL_SwapLE16(0);
+	fhdr->sectorsizeid = SDL_SwapLE16(3);
+	fhdr->hashoffset = SDL_SwapLE32(32872);
+	fhdr->blockoffset = SDL_SwapLE32(104);
+	fhdr->hashcount = SDL_SwapLE32(2048);
+	fhdr->blockcount = SDL_SwapLE32(2048);
+
+	memcpy(&pbImage[104], sgpBlockTbl, 0x8000);
+	Encrypt(&pbImage[104], 0x8000, Hash("(block table)", 3));
+	memcpy(&pbImage[32872], sgpHashTbl, 0x8000);
+	Encrypt(&pbImage[32872], 0x8000, Hash("(hash table)", 3));
+	*(DWORD *)&pbImage[MPQ_TABLES_SIZE] = SDL_SwapLE32(mpqapi_checksum(pbImage, MPQ_TABLES_SIZE));
 }
 
-BOOL mpqapi_write_hash_table()
+/**
+ * @brief Swap in the new tables once the file data they point at is on disk
+ *
+ * The tables go to a journal first and are then written over the old ones. A
+ * crash before the journal is complete keeps the old tables, which never point
+ * at space written since the archive was opened. A crash after it is finished
+ * by mpqapi_replay_tables.
+ */
+BOOL mpqapi_write_tables(const char *pszArchive)
 {
+	char szJournal[MAX_PATH];
+	HANDLE hJournal;
+	BYTE *pbImage;
+	DWORD dwWritten;
 	BOOL success;
-	DWORD NumberOfBytesWritten;
 
-	if (SetFilePointer(sghArchive, 32872, NULL, FILE_BEGIN) == -1)
-		return FALSE;
+	pbImage = DiabloAllocPtr(MPQ_TABLES_SIZE + 4);
+	mpqapi_build_tables(pbImage);
+	mpqapi_journal_name(szJournal, pszArchive);
+
+	success = FALSE;
+	if (!FlushFileBuffers(sghArchive))
+		goto done;
+	hJournal = CreateFile(szJournal, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+	if (hJournal == INVALID_HANDLE_VALUE)
+		goto done;
+	success = WriteFile(hJournal, pbImage, MPQ_TABLES_SIZE + 4, &dwWritten, NULL)
+	    && dwWritten == MPQ_TABLES_SIZE + 4
+	    && FlushFileBuffers(hJournal);
+	if (!CloseHandle(hJournal))
+		success = FALSE;
+	if (!success)
+		goto done;
+
+	success = SetFilePointer(sghArchive, 0, NULL, FILE_BEGIN) != -1
+	    && WriteFile(sghArchive, pbImage, MPQ_TABLES_SIZE, &dwWritten, NULL)
+	    && dwWritten == MPQ_TABLES_SIZE
+	    && FlushFileBuffers(sghArchive);
+	if (success)
+		DeleteFile(szJournal);
+done:
+	mem_free_dbg(pbImage);
+	return success;
+}
+
+/**
+ * @brief Finish a table swap that was cut short, before the tables are read
+ */
+BOOL mpqapi_replay_tables(const char *pszArchive)
+{
+	char szJournal[MAX_PATH];
+	HANDLE hJournal;
+	BYTE *pbImage;
+	DWORD dwRead, dwWritten;
+	BOOL complete, success;
+
+	mpqapi_journal_name(szJournal, pszArchive);
+	hJournal = CreateFile(szJournal, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+	if (hJournal == INVALID_HANDLE_VALUE)
+		return TRUE;
+	if (GetFileSize(sghArchive, NULL) == 0) {
+		// left over from a deleted archive
+		CloseHandle(hJournal);
+		DeleteFile(szJournal);
+		return TRUE;
+	}
 
-	Encrypt(sgpHashTbl, 0x8000, Hash("(hash table)", 3));
-	success = WriteFile(sghArchive, sgpHashTbl, 0x8000, &NumberOfBytesWritten, 0);
-	Decrypt(sgpHashTbl, 0x8000, Hash("(hash table)", 3));
-	return success && NumberOfBytesWritten == 0x8000;
+	pbImage = DiabloAllocPtr(MPQ_TABLES_SIZE + 4);
+	complete = ReadFile(hJournal, pbImage, MPQ_TABLES_SIZE + 4, &dwRead, NULL)
+	    && dwRead == MPQ_TABLES_SIZE + 4
+	    && SDL_SwapLE32(*(DWORD *)&pbImage[MPQ_TABLES_SIZE]) == mpqapi_checksum(pbImage, MPQ_TABLES_SIZE);
+	CloseHandle(hJournal);
+
+	// an incomplete journal means the old tables were never touched
+	success = TRUE;
+	if (complete) {
+		success = SetFilePointer(sghArchive, 0, NULL, FILE_BEGIN) != -1
+		    && WriteFile(sghArchive, pbImage, MPQ_TABLES_SIZE, &dwWritten, NULL)
+		    && dwWritten == MPQ_TABLES_SIZE
+		    && FlushFileBuffers(sghArchive)
+		    && SetFilePointer(sghArchive, 0, NULL, FILE_BEGIN) != -1;
+	}
+	if (success)
+		DeleteFile(szJournal);
+	mem_free_dbg(pbImage);
+	return success;
 }
 
 BOOL mpqapi_can_seek()
@@ -24,14 +24,13 @@ BOOL mpqapi_write_file_contents(const char *pszName, const BYTE *pbData, DWORD d
 int mpqapi_find_free_block(int size, int *block_size);
 void mpqapi_rename(char *pszOld, char *pszNew);
 BOOL mpqapi_has_file(const char *pszName);
-BOOL OpenMPQ(const char *pszArchive, BOOL hidden, DWORD dwChar);
+BOOL OpenMPQ(const char *pszArchive, BOOL hidden, BOOL is_single_player, DWORD dwChar);
 BOOL ParseMPQHeader(_FILEHEADER *pHdr, DWORD *pdwNextFileStart);
 void CloseMPQ(const char *pszArchive, BOOL bFree, DWORD dwChar);
 void mpqapi_store_modified_time(const char *pszArchive, DWORD dwChar);
 BOOL mpqapi_flush_and_close(const char *pszArchive, BOOL bFree, DWORD dwChar);
-BOOL WriteMPQHeader();
-BOOL mpqapi_write_block_table();
-BOOL mpqapi_write_hash_table();
+BOOL mpqapi_write_tables(const char *pszArchive);
+BOOL mpqapi_replay_tables(const char *pszArchive);
 BOOL mpqapi_can_seek();
 
 /* rdata */
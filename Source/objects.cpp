@@ -108,7 +108,7 @@ void InitObjectGFX()
 		if (fileload[i]) {
 			ObjFileList[numobjfiles] = i;
 			sprintf(filestr, "Objects\\%s.CEL", ObjMasterLoadList[i]);
-			pObjCels[numobjfiles] = LoadFileInMem(filestr, NULL);
+			pObjCels[numobjfiles] = LoadFileView(filestr, NULL);
 			numobjfiles++;
 		}
 	}
@@ -119,7 +119,7 @@ void FreeObjectGFX()
 	int i;
 
 	for (i = 0; i < numobjfiles; i++) {
-		MemFreeDbg(pObjCels[i]);
+		MemFreeView(pObjCels[i]);
 	}
 	numobjfiles = 0;
 }
@@ -885,7 +885,7 @@ void SetMapObjects(BYTE *pMap, int startx, int starty)
 
 		ObjFileList[numobjfiles] = i;
 		sprintf(filestr, "Objects\\%s.CEL", ObjMasterLoadList[i]);
-		pObjCels[numobjfiles] = LoadFileInMem(filestr, NULL);
+		pObjCels[numobjfiles] = LoadFileView(filestr, NULL);
 		numobjfiles++;
 	}
 
@@ -1800,8 +1800,8 @@ void ProcessObjects()
 	while (i < nobjects) {
 		oi = objectactive[i];
 		if (object[oi]._oDelFlag) {
+			// the last object moves in here, the ones before were already checked
 			DeleteObject_(oi, i);
-			i = 0;
 		} else {
 			i++;
 		}
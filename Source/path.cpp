@@ -20,6 +20,54 @@ PATHNODE *pnode_tblptr[MAXPATHNODES];
 PATHNODE *path_2_nodes;
 PATHNODE path_unusednodes[MAXPATHNODES];
 
+// one frontier bucket per possible value of PATHNODE::f
+#define PATH_BUCKETS (CHAR_MAX - CHAR_MIN + 1)
+#define PATH_BUCKET(f) ((f) - CHAR_MIN)
+
+// first and last frontier node of each f value, only kept up while the frontier is sorted
+static PATHNODE *path_bucket_first[PATH_BUCKETS];
+static PATHNODE *path_bucket_last[PATH_BUCKETS];
+// bucket of the frontier head, PATH_BUCKETS if the frontier is empty
+static int path_bucket_min;
+// range of buckets touched by the current search, cleared by the next one
+static int path_bucket_lo;
+static int path_bucket_hi;
+// cleared once a node changes its f in place in a way that leaves the frontier unsorted
+static BOOL path_frontier_sorted;
+// (search generation << 9) | (node index + 1) for every tile that has a node in the current search
+static int path_node_map[MAXDUNX][MAXDUNY];
+static int path_generation;
+// TRUE while the matching path_nodes entry is on the frontier, FALSE once visited
+static BOOLEAN path_node_frontier[MAXPATHNODES];
+
+// FindPath never returns more than 24 steps, so a field only has to cover that far around its target
+#define FLOW_RADIUS 24
+#define FLOW_SIZE (2 * FLOW_RADIUS + 1)
+#define FLOW_MAX_COST (FLOW_RADIUS * 3)
+#define FLOW_UNREACHED 0xFF
+// usually one field per targeted player
+#define FLOW_FIELDS 4
+
+typedef struct FlowField {
+	BOOL (*PosOk)(int, int, int);
+	int key;
+	int dx;
+	int dy;
+	// path cost from each tile to (dx,dy) using the FindPath step costs
+	BYTE cost[FLOW_SIZE][FLOW_SIZE];
+	// number of steps on that path
+	BYTE steps[FLOW_SIZE][FLOW_SIZE];
+	// path_directions value of the first step from each tile
+	char dir[FLOW_SIZE][FLOW_SIZE];
+} FlowField;
+
+static FlowField flow_fields[FLOW_FIELDS];
+static int flow_numfields;
+// bucket queue of tiles (packed as x * FLOW_SIZE + y) by cost, for the field being built
+static short flow_queue_tile[FLOW_SIZE * FLOW_SIZE * 8 + 1];
+static short flow_queue_next[FLOW_SIZE * FLOW_SIZE * 8 + 1];
+static short flow_queue_head[FLOW_MAX_COST + 1];
+
 // for iterating over the 8 possible movement directions
 const char pathxdir[8] = { -1, -1, 1, 1, -1, 0, 1, 0 };
 const char pathydir[8] = { -1, 1, -1, 1, 0, -1, 0, 1 };
@@ -36,6 +84,114 @@ const char pathydir[8] = { -1, 1, -1, 1, 0, -1, 0, 1 };
  */
 char path_directions[9] = { 5, 1, 6, 2, 0, 3, 8, 4, 7 };
 
+/**
+ * @brief forget the nodes of the previous search in the tile map and the frontier buckets
+ */
+static void path_reset_index()
+{
+	int i;
+
+	path_generation++;
+	if (path_generation >= 1 << 22) {
+		memset(path_node_map, 0, sizeof(path_node_map));
+		path_generation = 1;
+	}
+	for (i = path_bucket_lo; i <= path_bucket_hi; i++) {
+		path_bucket_first[i] = NULL;
+		path_bucket_last[i] = NULL;
+	}
+	path_bucket_lo = PATH_BUCKETS;
+	path_bucket_hi = -1;
+	path_bucket_min = PATH_BUCKETS;
+	path_frontier_sorted = TRUE;
+}
+
+/**
+ * @brief return the node of the current search at (dx,dy), frontier or visited, or NULL
+ */
+static PATHNODE *path_map_node(int dx, int dy)
+{
+	int v;
+
+	v = path_node_map[dx][dy];
+	if (v >> 9 != path_generation)
+		return NULL;
+	return &path_nodes[(v & 0x1FF) - 1];
+}
+
+/**
+ * @brief keep track of the bucket range that path_reset_index has to clear
+ */
+static void path_touch_bucket(int b)
+{
+	if (path_bucket_lo > b)
+		path_bucket_lo = b;
+	if (path_bucket_hi < b)
+		path_bucket_hi = b;
+}
+
+/**
+ * @brief set the f cost of pPath, moving it between frontier buckets if it stays sorted
+ *
+ * The node keeps its place in the frontier list just like before, if that
+ * breaks the ordering the buckets are dropped for the rest of the search
+ */
+static void path_set_f(PATHNODE *pPath, char f)
+{
+	int ob, nb, b;
+
+	ob = PATH_BUCKET(pPath->f);
+	nb = PATH_BUCKET(f);
+	pPath->f = f;
+	if (!path_frontier_sorted || !path_node_frontier[pPath - path_nodes] || ob == nb)
+		return;
+
+	if (nb < ob) {
+		// must be the first of its bucket with nothing in between, then it simply joins the end of the lower bucket
+		if (path_bucket_first[ob] != pPath) {
+			path_frontier_sorted = FALSE;
+			return;
+		}
+		for (b = nb + 1; b < ob; b++) {
+			if (path_bucket_first[b] != NULL) {
+				path_frontier_sorted = FALSE;
+				return;
+			}
+		}
+		if (path_bucket_last[ob] == pPath) {
+			path_bucket_first[ob] = NULL;
+			path_bucket_last[ob] = NULL;
+		} else {
+			path_bucket_first[ob] = pPath->NextNode;
+		}
+		if (path_bucket_first[nb] == NULL)
+			path_bucket_first[nb] = pPath;
+		path_bucket_last[nb] = pPath;
+		if (path_bucket_min > nb)
+			path_bucket_min = nb;
+	} else {
+		// only happens when g wraps around, keep it simple and require the node to be alone in its bucket
+		if (path_bucket_first[ob] != pPath || path_bucket_last[ob] != pPath) {
+			path_frontier_sorted = FALSE;
+			return;
+		}
+		for (b = ob + 1; b < nb; b++) {
+			if (path_bucket_first[b] != NULL) {
+				path_frontier_sorted = FALSE;
+				return;
+			}
+		}
+		path_bucket_first[ob] = NULL;
+		path_bucket_last[ob] = NULL;
+		if (path_bucket_last[nb] == NULL)
+			path_bucket_last[nb] = pPath;
+		path_bucket_first[nb] = pPath;
+		if (path_bucket_min == ob)
+			path_bucket_min = nb;
+	}
+	path_touch_bucket(nb);
+}
+
 /**
  * find the shortest path from (sx,sy) to (dx,dy), using PosOk(PosOkArg,x,y) to
  * check that each step is a valid position. Store the step directions (see
@@ -51,13 +207,14 @@ int FindPath(BOOL (*PosOk)(int, int, int), int PosOkArg, int sx, int sy, int dx,
 	path_2_nodes = path_new_step();
 	pnode_ptr = path_new_step();
 	gdwCurPathStep = 0;
+	path_reset_index();
 	path_start = path_new_step();
 	path_start->g = 0;
 	path_start->h = path_get_h_cost(sx, sy, dx, dy);
 	path_start->x = sx;
 	path_start->f = path_start->h + path_start->g;
 	path_start->y = sy;
-	path_2_nodes->NextNode = path_start;
+	path_next_node(path_start);
 	// A* search until we find (dx,dy) or fail
 	while ((next_node = GetNextPath())) {
 		// reached the end, success!
@@ -86,6 +243,152 @@ int FindPath(BOOL (*PosOk)(int, int, int), int PosOkArg, int sx, int sy, int dx,
 	return 0;
 }
 
+/**
+ * @brief forget all flow fields, they are only valid while the dungeon does not change
+ */
+void ClearFlowFields()
+{
+	flow_numfields = 0;
+}
+
+/**
+ * @brief fill in the cost of every tile within FLOW_RADIUS of (pField->dx,pField->dy), walking backwards from it
+ *
+ * The same steps as path_get_path are allowed: every tile entered must pass
+ * PosOk and not cut a corner, except the target which may always be entered if
+ * PosOk rejects it
+ */
+static void path_build_flow_field(FlowField *pField, int PosOkArg)
+{
+	PATHNODE from;
+	int c, i, q, numq, tile, x, y, fx, fy, nx, ny, next;
+	BOOL destok;
+
+	memset(pField->cost, FLOW_UNREACHED, sizeof(pField->cost));
+	memset(flow_queue_head, -1, sizeof(flow_queue_head));
+	destok = pField->PosOk(PosOkArg, pField->dx, pField->dy);
+	pField->cost[FLOW_RADIUS][FLOW_RADIUS] = 0;
+	pField->steps[FLOW_RADIUS][FLOW_RADIUS] = 0;
+	pField->dir[FLOW_RADIUS][FLOW_RADIUS] = 0;
+	flow_queue_tile[0] = FLOW_RADIUS * FLOW_SIZE + FLOW_RADIUS;
+	flow_queue_next[0] = -1;
+	flow_queue_head[0] = 0;
+	numq = 1;
+
+	for (c = 0; c <= FLOW_MAX_COST; c++) {
+		while ((q = flow_queue_head[c]) != -1) {
+			flow_queue_head[c] = flow_queue_next[q];
+			tile = flow_queue_tile[q];
+			fx = tile / FLOW_SIZE;
+			fy = tile % FLOW_SIZE;
+			if (pField->cost[fx][fy] != c || pField->steps[fx][fy] == FLOW_RADIUS)
+				continue;
+			x = pField->dx + fx - FLOW_RADIUS;
+			y = pField->dy + fy - FLOW_RADIUS;
+			for (i = 0; i < 8; i++) {
+				nx = fx + pathxdir[i];
+				ny = fy + pathydir[i];
+				if ((DWORD)nx >= FLOW_SIZE || (DWORD)ny >= FLOW_SIZE)
+					continue;
+				from.x = x + pathxdir[i];
+				from.y = y + pathydir[i];
+				if ((DWORD)from.x >= MAXDUNX || (DWORD)from.y >= MAXDUNY)
+					continue;
+				next = c + path_check_equal(&from, x, y);
+				if (next >= pField->cost[nx][ny] || next > FLOW_MAX_COST)
+					continue;
+				if (!pField->PosOk(PosOkArg, from.x, from.y))
+					continue;
+				if ((c != 0 || destok) && !path_solid_pieces(&from, x, y))
+					continue;
+				pField->cost[nx][ny] = next;
+				pField->steps[nx][ny] = pField->steps[fx][fy] + 1;
+				pField->dir[nx][ny] = path_directions[3 * -pathydir[i] - pathxdir[i] + 4];
+				flow_queue_tile[numq] = nx * FLOW_SIZE + ny;
+				flow_queue_next[numq] = flow_queue_head[next];
+				flow_queue_head[next] = numq;
+				numq++;
+			}
+		}
+	}
+}
+
+/**
+ * like FindPath, but the steps are read from a flow field towards (dx,dy)
+ * that is shared by every caller passing the same PosOk and key. The field is
+ * built with PosOk(PosOkArg,x,y) of the first caller, so callers may only
+ * share a key if PosOk gives them the same answer on every tile but their own.
+ * Falls back to FindPath once all fields of this tick are taken
+ */
+int FindPathFlow(BOOL (*PosOk)(int, int, int), int PosOkArg, int key, int sx, int sy, int dx, int dy, char *path)
+{
+	FlowField *pField;
+	PATHNODE from;
+	int i, x, y, fx, fy, c, best, bestdir, path_length;
+
+	pField = NULL;
+	for (i = 0; i < flow_numfields; i++) {
+		if (flow_fields[i].PosOk == PosOk && flow_fields[i].key == key && flow_fields[i].dx == dx && flow_fields[i].dy == dy) {
+			pField = &flow_fields[i];
+			break;
+		}
+	}
+	if (pField == NULL) {
+		if (flow_numfields == FLOW_FIELDS)
+			return FindPath(PosOk, PosOkArg, sx, sy, dx, dy, path);
+		pField = &flow_fields[flow_numfields++];
+		pField->PosOk = PosOk;
+		pField->key = key;
+		pField->dx = dx;
+		pField->dy = dy;
+		path_build_flow_field(pField, PosOkArg);
+	}
+
+	// the start tile itself is never checked, so pick the first step by hand
+	from.x = sx;
+	from.y = sy;
+	best = FLOW_UNREACHED;
+	bestdir = -1;
+	for (i = 0; i < 8; i++) {
+		x = sx + pathxdir[i];
+		y = sy + pathydir[i];
+		fx = x - dx + FLOW_RADIUS;
+		fy = y - dy + FLOW_RADIUS;
+		if ((DWORD)fx >= FLOW_SIZE || (DWORD)fy >= FLOW_SIZE)
+			continue;
+		if (pField->cost[fx][fy] == FLOW_UNREACHED || pField->steps[fx][fy] >= 24)
+			continue;
+		if (x == dx && y == dy && !PosOk(PosOkArg, x, y)) {
+			c = path_check_equal(&from, x, y);
+		} else {
+			if (!path_solid_pieces(&from, x, y))
+				continue;
+			c = pField->cost[fx][fy] + path_check_equal(&from, x, y);
+		}
+		if (c < best) {
+			best = c;
+			bestdir = i;
+		}
+	}
+	if (bestdir == -1)
+		return 0;
+
+	path[0] = path_directions[3 * pathydir[bestdir] + pathxdir[bestdir] + 4];
+	path_length = 1;
+	fx = sx + pathxdir[bestdir] - dx + FLOW_RADIUS;
+	fy = sy + pathydir[bestdir] - dy + FLOW_RADIUS;
+	while (fx != FLOW_RADIUS || fy != FLOW_RADIUS) {
+		path[path_length++] = pField->dir[fx][fy];
+		for (i = 0; i < 8; i++) {
+			if (path_directions[3 * pathydir[i] + pathxdir[i] + 4] == pField->dir[fx][fy])
+				break;
+		}
+		fx += pathxdir[i];
+		fy += pathydir[i];
+	}
+	return path_length;
+}
+
 /**
  * @brief heuristic, estimated cost from (sx,sy) to (dx,dy)
  */
@@ -122,12 +425,25 @@ int path_check_equal(PATHNODE *pPath, int dx, int dy)
 PATHNODE *GetNextPath()
 {
 	PATHNODE *result;
+	int b;
 
 	result = path_2_nodes->NextNode;
 	if (result == NULL) {
 		return result;
 	}
 
+	if (path_frontier_sorted) {
+		b = PATH_BUCKET(result->f);
+		if (path_bucket_last[b] == result) {
+			path_bucket_first[b] = NULL;
+			path_bucket_last[b] = NULL;
+			path_bucket_min = result->NextNode != NULL ? PATH_BUCKET(result->NextNode->f) : PATH_BUCKETS;
+		} else {
+			path_bucket_first[b] = result->NextNode;
+		}
+	}
+	path_node_frontier[result - path_nodes] = FALSE;
+
 	path_2_nodes->NextNode = result->NextNode;
 	result->NextNode = pnode_ptr->NextNode;
 	pnode_ptr->NextNode = result;
@@ -215,7 +531,7 @@ BOOL path_parent_path(PATHNODE *pPath, int dx, int dy, int sx, int sy)
 				// we'll explore it later, just update
 				dxdy->Parent = pPath;
 				dxdy->g = next_g;
-				dxdy->f = next_g + dxdy->h;
+				path_set_f(dxdy, next_g + dxdy->h);
 			}
 		}
 	} else {
@@ -264,7 +580,14 @@ BOOL path_parent_path(PATHNODE *pPath, int dx, int dy, int sx, int sy)
  */
 PATHNODE *path_get_node1(int dx, int dy)
 {
-	PATHNODE *result = path_2_nodes->NextNode;
+	PATHNODE *result;
+
+	if ((DWORD)dx < MAXDUNX && (DWORD)dy < MAXDUNY) {
+		result = path_map_node(dx, dy);
+		return result != NULL && path_node_frontier[result - path_nodes] ? result : NULL;
+	}
+
+	result = path_2_nodes->NextNode;
 	while (result != NULL && (result->x != dx || result->y != dy))
 		result = result->NextNode;
 	return result;
@@ -275,7 +598,14 @@ PATHNODE *path_get_node1(int dx, int dy)
  */
 PATHNODE *path_get_node2(int dx, int dy)
 {
-	PATHNODE *result = pnode_ptr->NextNode;
+	PATHNODE *result;
+
+	if ((DWORD)dx < MAXDUNX && (DWORD)dy < MAXDUNY) {
+		result = path_map_node(dx, dy);
+		return result != NULL && !path_node_frontier[result - path_nodes] ? result : NULL;
+	}
+
+	result = pnode_ptr->NextNode;
 	while (result != NULL && (result->x != dx || result->y != dy))
 		result = result->NextNode;
 	return result;
@@ -287,7 +617,32 @@ PATHNODE *path_get_node2(int dx, int dy)
 void path_next_node(PATHNODE *pPath)
 {
 	PATHNODE *next, *current;
-	int f;
+	int f, b;
+
+	path_node_frontier[pPath - path_nodes] = TRUE;
+	if ((DWORD)pPath->x < MAXDUNX && (DWORD)pPath->y < MAXDUNY)
+		path_node_map[pPath->x][pPath->y] = path_generation << 9 | (pPath - path_nodes + 1);
+
+	if (path_frontier_sorted) {
+		// same spot the scan below finds: after the last node of the closest lower bucket
+		f = PATH_BUCKET(pPath->f);
+		current = path_2_nodes;
+		for (b = f - 1; b >= path_bucket_min; b--) {
+			if (path_bucket_last[b] != NULL) {
+				current = path_bucket_last[b];
+				break;
+			}
+		}
+		pPath->NextNode = current->NextNode;
+		current->NextNode = pPath;
+		if (path_bucket_last[f] == NULL)
+			path_bucket_last[f] = pPath;
+		path_bucket_first[f] = pPath;
+		if (path_bucket_min > f)
+			path_bucket_min = f;
+		path_touch_bucket(f);
+		return;
+	}
 
 	next = path_2_nodes;
 	if (!path_2_nodes->NextNode) {
@@ -326,7 +681,7 @@ void path_set_coords(PATHNODE *pPath)
 				if (path_solid_pieces(PathOld, PathAct->x, PathAct->y)) {
 					PathAct->Parent = PathOld;
 					PathAct->g = PathOld->g + path_check_equal(PathOld, PathAct->x, PathAct->y);
-					PathAct->f = PathAct->g + PathAct->h;
+					path_set_f(PathAct, PathAct->g + PathAct->h);
 					path_push_active_step(PathAct);
 				}
 			}
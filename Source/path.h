@@ -12,6 +12,8 @@ extern PATHNODE *path_2_nodes;
 extern PATHNODE path_unusednodes[MAXPATHNODES];
 
 int FindPath(BOOL (*PosOk)(int, int, int), int PosOkArg, int sx, int sy, int dx, int dy, char *path);
+void ClearFlowFields();
+int FindPathFlow(BOOL (*PosOk)(int, int, int), int PosOkArg, int key, int sx, int sy, int dx, int dy, char *path);
 int path_get_h_cost(int sx, int sy, int dx, int dy);
 int path_check_equal(PATHNODE *pPath, int dx, int dy);
 PATHNODE *GetNextPath();
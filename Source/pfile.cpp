@@ -15,17 +15,32 @@ DEVILUTION_BEGIN_NAMESPACE
 static char hero_names[MAX_CHARACTERS][PLR_NAME_LEN];
 BOOL gbValidSaveFile;
 
+static BOOL pfile_open_mpq(const char *pszArchive, BOOL update, BOOL is_single_player, DWORD save_num);
+static BOOL pfile_close_mpq(const char *pszArchive, BOOL is_single_player, DWORD save_num);
+
 void pfile_write_hero()
 {
 	DWORD save_num;
 	PkPlayerStruct pkplr;
 
 	save_num = pfile_get_save_num_from_name(plr[myplr]._pName);
-	if (pfile_open_archive(TRUE, save_num)) {
-		PackPlayer(&pkplr, myplr, gbMaxPlayers == 1);
-		pfile_encode_hero(&pkplr);
-		pfile_flush(gbMaxPlayers == 1, save_num);
-	}
+	PackPlayer(&pkplr, myplr, gbMaxPlayers == 1);
+	sthread_save_hero(&pkplr, save_num);
+}
+
+/**
+ * @brief Write a packed hero into its save archive, called by the save thread
+ * @param is_single_player Game type as of queuing the save, gbMaxPlayers may have changed since
+ */
+BOOL pfile_commit_hero(const PkPlayerStruct *pPack, BOOL is_single_player, DWORD save_num)
+{
+	char FileName[MAX_PATH];
+
+	pfile_get_save_path(FileName, sizeof(FileName), is_single_player, save_num);
+	if (!pfile_open_mpq(FileName, TRUE, is_single_player, save_num))
+		return FALSE;
+	pfile_encode_hero(pPack, is_single_player);
+	return pfile_close_mpq(FileName, is_single_player, save_num);
 }
 
 DWORD pfile_get_save_num_from_name(const char *name)
@@ -40,13 +55,13 @@ DWORD pfile_get_save_num_from_name(const char *name)
 	return i;
 }
 
-void pfile_encode_hero(const PkPlayerStruct *pPack)
+void pfile_encode_hero(const PkPlayerStruct *pPack, BOOL is_single_player)
 {
 	BYTE *packed;
 	DWORD packed_len;
 	char password[16] = PASSWORD_SINGLE;
 
-	if (gbMaxPlayers > 1)
+	if (!is_single_player)
 		strcpy(password, PASSWORD_MULTI);
 
 	packed_len = codec_get_encoded_len(sizeof(*pPack));
@@ -61,28 +76,37 @@ BOOL pfile_open_archive(BOOL update, DWORD save_num)
 {
 	char FileName[MAX_PATH];
 
-	pfile_get_save_path(FileName, sizeof(FileName), save_num);
-	if (OpenMPQ(FileName, FALSE, save_num))
+	sthread_wait();
+	pfile_get_save_path(FileName, sizeof(FileName), gbMaxPlayers == 1, save_num);
+	return pfile_open_mpq(FileName, update, gbMaxPlayers == 1, save_num);
+}
+
+/**
+ * @brief Open a save archive for writing without waiting for the save thread
+ */
+static BOOL pfile_open_mpq(const char *pszArchive, BOOL update, BOOL is_single_player, DWORD save_num)
+{
+	if (OpenMPQ(pszArchive, FALSE, is_single_player, save_num))
 		return TRUE;
 
-	if (update && gbMaxPlayers > 1)
+	if (update && !is_single_player)
 		mpqapi_store_default_time(save_num);
 	return FALSE;
 }
 
-void pfile_get_save_path(char *pszBuf, DWORD dwBufSize, DWORD save_num)
+void pfile_get_save_path(char *pszBuf, DWORD dwBufSize, BOOL is_single_player, DWORD save_num)
 {
 	char path[MAX_PATH];
 
 #ifdef SPAWN
 	const char *fmt = "%sshare_%d.sv";
 
-	if (gbMaxPlayers <= 1)
+	if (is_single_player)
 		fmt = "%sspawn%d.sv";
 #else
 	const char *fmt = "%smulti_%d.sv";
 
-	if (gbMaxPlayers <= 1)
+	if (is_single_player)
 		fmt = "%ssingle_%d.sv";
 #endif
 
@@ -94,8 +118,31 @@ void pfile_flush(BOOL is_single_player, DWORD save_num)
 {
 	char FileName[MAX_PATH];
 
-	pfile_get_save_path(FileName, sizeof(FileName), save_num);
-	mpqapi_flush_and_close(FileName, is_single_player, save_num);
+	pfile_get_save_path(FileName, sizeof(FileName), gbMaxPlayers == 1, save_num);
+	if (!pfile_close_mpq(FileName, is_single_player, save_num))
+		pfile_save_failed(NULL);
+}
+
+static BOOL pfile_close_mpq(const char *pszArchive, BOOL is_single_player, DWORD save_num)
+{
+	return mpqapi_flush_and_close(pszArchive, is_single_player, save_num);
+}
+
+/**
+ * @brief Tell the player a save did not make it to disk
+ * @param pszName Name of the file in the save archive, NULL if not known
+ */
+void pfile_save_failed(const char *pszName)
+{
+	char text[MAX_PATH + 128];
+
+	if (pszName == NULL) {
+		UiErrorOkDialog("Out of Disk Space", "Failed to save, please free some disk space and try again.");
+		return;
+	}
+
+	snprintf(text, sizeof(text), "Failed to save %s, please free some disk space and try again.", pszName);
+	UiErrorOkDialog("Out of Disk Space", text);
 }
 
 BOOL pfile_create_player_description(char *dst, DWORD len)
@@ -150,6 +197,7 @@ BOOL pfile_rename_hero(const char *name_1, const char *name_2)
 
 void pfile_flush_W()
 {
+	sthread_wait();
 	pfile_flush(TRUE, pfile_get_save_num_from_name(plr[myplr]._pName));
 }
 
@@ -267,7 +315,8 @@ HANDLE pfile_open_save_archive(BOOL *showFixedMsg, DWORD save_num)
 	char SrcStr[MAX_PATH];
 	HANDLE archive;
 
-	pfile_get_save_path(SrcStr, sizeof(SrcStr), save_num);
+	sthread_wait();
+	pfile_get_save_path(SrcStr, sizeof(SrcStr), gbMaxPlayers == 1, save_num);
 	if (SFileOpenArchive(SrcStr, 0x7000, FS_PC, &archive))
 		return archive;
 	return NULL;
@@ -342,7 +391,7 @@ BOOL __stdcall pfile_ui_save_create(_uiheroinfo *heroinfo)
 	strncpy(plr[0]._pName, heroinfo->name, PLR_NAME_LEN);
 	plr[0]._pName[PLR_NAME_LEN - 1] = '\0';
 	PackPlayer(&pkplr, 0, TRUE);
-	pfile_encode_hero(&pkplr);
+	pfile_encode_hero(&pkplr, gbMaxPlayers == 1);
 	game_2_ui_player(&plr[0], heroinfo, FALSE);
 	pfile_flush(TRUE, save_num);
 	return TRUE;
@@ -380,8 +429,9 @@ BOOL __stdcall pfile_delete_save(_uiheroinfo *hero_info)
 
 	save_num = pfile_get_save_num_from_name(hero_info->name);
 	if (save_num < MAX_CHARACTERS) {
+		sthread_wait();
 		hero_names[save_num][0] = '\0';
-		pfile_get_save_path(FileName, sizeof(FileName), save_num);
+		pfile_get_save_path(FileName, sizeof(FileName), gbMaxPlayers == 1, save_num);
 		DeleteFile(FileName);
 	}
 	return TRUE;
@@ -513,24 +563,39 @@ BOOL __stdcall GetPermSaveNames(DWORD dwIndex, char *szPerm)
 	return TRUE;
 }
 
+/**
+ * @brief Queue a save file for the save thread
+ * @param pbData Buffer of qwLen bytes holding dwLen bytes of save data, owned by the save thread from now on
+ */
 void pfile_write_save_file(const char *pszName, BYTE *pbData, DWORD dwLen, DWORD qwLen)
 {
 	DWORD save_num;
-	char FileName[MAX_PATH];
 
-	pfile_strcpy(FileName, pszName);
 	save_num = pfile_get_save_num_from_name(plr[myplr]._pName);
+	sthread_save_file(pszName, pbData, dwLen, qwLen, save_num);
+}
+
+/**
+ * @brief Encode a save file and write it into the save archive, called by the save thread
+ * @param is_single_player Game type as of queuing the save, gbMaxPlayers may have changed since
+ */
+BOOL pfile_commit_save_file(const char *pszName, BYTE *pbData, DWORD dwLen, DWORD qwLen, BOOL is_single_player, DWORD save_num)
+{
+	BOOL success;
+	char FileName[MAX_PATH];
+
 	{
 		char password[16] = PASSWORD_SINGLE;
-		if (gbMaxPlayers > 1)
+		if (!is_single_player)
 			strcpy(password, PASSWORD_MULTI);
 
 		codec_encode(pbData, dwLen, qwLen, password);
 	}
-	if (!pfile_open_archive(FALSE, save_num))
-		app_fatal("Unable to write so save file archive");
-	mpqapi_write_file(FileName, pbData, qwLen);
-	pfile_flush(TRUE, save_num);
+	pfile_get_save_path(FileName, sizeof(FileName), is_single_player, save_num);
+	if (!pfile_open_mpq(FileName, FALSE, is_single_player, save_num))
+		return FALSE;
+	success = mpqapi_write_file(pszName, pbData, qwLen);
+	return pfile_close_mpq(FileName, TRUE, save_num) && success;
 }
 
 void pfile_strcpy(char *dst, const char *src)
@@ -596,6 +661,7 @@ void pfile_update(BOOL force_save)
 	// BUGFIX: these tick values should be treated as unsigned to handle overflows correctly
 	static int save_prev_tc;
 
+	sthread_poll();
 	if (gbMaxPlayers != 1) {
 		int tick = GetTickCount();
 		if (force_save || tick - save_prev_tc > 60000) {
@@ -7,11 +7,13 @@ extern BOOL gbValidSaveFile;
 void pfile_init_save_directory();
 void pfile_check_available_space(char *pszDir);
 void pfile_write_hero();
+BOOL pfile_commit_hero(const PkPlayerStruct *pPack, BOOL is_single_player, DWORD save_num);
 DWORD pfile_get_save_num_from_name(const char *name);
-void pfile_encode_hero(const PkPlayerStruct *pPack);
+void pfile_encode_hero(const PkPlayerStruct *pPack, BOOL is_single_player);
 BOOL pfile_open_archive(BOOL update, DWORD save_num);
-void pfile_get_save_path(char *pszBuf, DWORD dwBufSize, DWORD save_num);
+void pfile_get_save_path(char *pszBuf, DWORD dwBufSize, BOOL is_single_player, DWORD save_num);
 void pfile_flush(BOOL is_single_player, DWORD save_num);
+void pfile_save_failed(const char *pszName);
 BOOL pfile_create_player_description(char *dst, DWORD len);
 BOOL pfile_rename_hero(const char *name_1, const char *name_2);
 void pfile_flush_W();
@@ -37,6 +39,7 @@ BOOL __stdcall GetTempSaveNames(DWORD dwIndex, char *szTemp);
 void pfile_rename_temp_to_perm();
 BOOL __stdcall GetPermSaveNames(DWORD dwIndex, char *szPerm);
 void pfile_write_save_file(const char *pszName, BYTE *pbData, DWORD dwLen, DWORD qwLen);
+BOOL pfile_commit_save_file(const char *pszName, BYTE *pbData, DWORD dwLen, DWORD qwLen, BOOL is_single_player, DWORD save_num);
 void pfile_strcpy(char *dst, const char *src);
 BYTE *pfile_read(const char *pszName, DWORD *pdwLen);
 void pfile_update(BOOL force_save);
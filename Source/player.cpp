@@ -2,21 +2,10 @@
 
 DEVILUTION_BEGIN_NAMESPACE
 
-int plr_lframe_size;
-int plr_wframe_size;
-BYTE plr_gfx_flag = 0;
-int plr_aframe_size;
 int myplr;
 PlayerStruct plr[MAX_PLRS];
-int plr_fframe_size;
-int plr_qframe_size;
 BOOL deathflag;
-int plr_hframe_size;
-int plr_bframe_size;
-BYTE plr_gfx_bflag = 0;
-int plr_sframe_size;
 int deathdelay;
-int plr_dframe_size;
 
 const char ArmourChar[4] = { 'L', 'M', 'H', 0 };
 const char WepChar[10] = { 'N', 'U', 'S', 'D', 'B', 'A', 'M', 'H', 'T', 0 };
@@ -131,23 +120,86 @@ void SetPlayerGPtrs(BYTE *pData, BYTE **pAnim)
 	}
 }
 
-void LoadPlrGFX(int pnum, player_graphic gfxflag)
+/**
+ * @brief Build the file name of one of a player's animations
+ * @param pszName Buffer for the name, 256 characters
+ * @param pc Class of the player
+ * @param gfxnum Armour and weapon animation ID, as in _pgfxnum
+ * @param town The animation is for town, which has its own stand and walk and no fighting
+ * @param gfx The animation, a single player_graphic bit
+ * @return FALSE if there is no such animation for the gear or the level
+ */
+BOOL GetPlrGFXName(char *pszName, int pc, int gfxnum, BOOL town, player_graphic gfx)
 {
 	char prefix[16];
-	char pszName[256];
 	char *szCel;
+
+	switch (gfx) {
+	case PFILE_STAND:
+		szCel = "AS";
+		if (town) {
+			szCel = "ST";
+		}
+		break;
+	case PFILE_WALK:
+		szCel = "AW";
+		if (town) {
+			szCel = "WL";
+		}
+		break;
+	case PFILE_ATTACK:
+		szCel = "AT";
+		break;
+	case PFILE_HIT:
+		szCel = "HT";
+		break;
+	case PFILE_LIGHTNING:
+		szCel = "LM";
+		break;
+	case PFILE_FIRE:
+		szCel = "FM";
+		break;
+	case PFILE_MAGIC:
+		szCel = "QM";
+		break;
+	case PFILE_DEATH:
+		if (gfxnum & 0xF) {
+			return FALSE;
+		}
+		szCel = "DT";
+		break;
+	case PFILE_BLOCK:
+		szCel = "BL";
+		break;
+	default:
+		app_fatal("PLR:2");
+		break;
+	}
+	if (town && gfx != PFILE_STAND && gfx != PFILE_WALK && gfx != PFILE_DEATH) {
+		return FALSE;
+	}
+
+	sprintf(prefix, "%c%c%c", CharChar[pc], ArmourChar[gfxnum >> 4], WepChar[gfxnum & 0xF]);
+	sprintf(pszName, "PlrGFX\\%s\\%s\\%s%s.CL2", ClassStrTbl[pc], prefix, prefix, szCel);
+	return TRUE;
+}
+
+void LoadPlrGFX(int pnum, player_graphic gfxflag)
+{
+	char pszName[256];
 	PlayerStruct *p;
-	char *cs;
-	BYTE *pData, *pAnim;
+	BYTE **ppData, **pAnim, *pData;
 	DWORD i;
+	int d;
 
 	if ((DWORD)pnum >= MAX_PLRS) {
 		app_fatal("LoadPlrGFX: illegal player %d", pnum);
 	}
 
+	// let a set still loading for a gear change finish rather than load its files twice
+	plrgfx_finish(pnum);
+
 	p = &plr[pnum];
-	sprintf(prefix, "%c%c%c", CharChar[p->_pClass], ArmourChar[p->_pgfxnum >> 4], WepChar[p->_pgfxnum & 0xF]);
-	cs = ClassStrTbl[p->_pClass];
 
 	for (i = 1; i <= PFILE_NONDEATH; i <<= 1) {
 		if (!(i & gfxflag)) {
@@ -156,89 +208,64 @@ void LoadPlrGFX(int pnum, player_graphic gfxflag)
 
 		switch (i) {
 		case PFILE_STAND:
-			szCel = "AS";
-			if (leveltype == DTYPE_TOWN) {
-				szCel = "ST";
-			}
-			pData = p->_pNData;
-			pAnim = (BYTE *)p->_pNAnim;
+			ppData = &p->_pNData;
+			pAnim = p->_pNAnim;
 			break;
 		case PFILE_WALK:
-			szCel = "AW";
-			if (leveltype == DTYPE_TOWN) {
-				szCel = "WL";
-			}
-			pData = p->_pWData;
-			pAnim = (BYTE *)p->_pWAnim;
+			ppData = &p->_pWData;
+			pAnim = p->_pWAnim;
 			break;
 		case PFILE_ATTACK:
-			if (leveltype == DTYPE_TOWN) {
-				continue;
-			}
-			szCel = "AT";
-			pData = p->_pAData;
-			pAnim = (BYTE *)p->_pAAnim;
+			ppData = &p->_pAData;
+			pAnim = p->_pAAnim;
 			break;
 		case PFILE_HIT:
-			if (leveltype == DTYPE_TOWN) {
-				continue;
-			}
-			szCel = "HT";
-			pData = p->_pHData;
-			pAnim = (BYTE *)p->_pHAnim;
+			ppData = &p->_pHData;
+			pAnim = p->_pHAnim;
 			break;
 		case PFILE_LIGHTNING:
-			if (leveltype == DTYPE_TOWN) {
-				continue;
-			}
-			szCel = "LM";
-			pData = p->_pLData;
-			pAnim = (BYTE *)p->_pLAnim;
+			ppData = &p->_pLData;
+			pAnim = p->_pLAnim;
 			break;
 		case PFILE_FIRE:
-			if (leveltype == DTYPE_TOWN) {
-				continue;
-			}
-			szCel = "FM";
-			pData = p->_pFData;
-			pAnim = (BYTE *)p->_pFAnim;
+			ppData = &p->_pFData;
+			pAnim = p->_pFAnim;
 			break;
 		case PFILE_MAGIC:
-			if (leveltype == DTYPE_TOWN) {
-				continue;
-			}
-			szCel = "QM";
-			pData = p->_pTData;
-			pAnim = (BYTE *)p->_pTAnim;
+			ppData = &p->_pTData;
+			pAnim = p->_pTAnim;
 			break;
 		case PFILE_DEATH:
-			if (p->_pgfxnum & 0xF) {
-				continue;
-			}
-			szCel = "DT";
-			pData = p->_pDData;
-			pAnim = (BYTE *)p->_pDAnim;
+			ppData = &p->_pDData;
+			pAnim = p->_pDAnim;
 			break;
 		case PFILE_BLOCK:
-			if (leveltype == DTYPE_TOWN) {
-				continue;
-			}
 			if (!p->_pBlockFlag) {
 				continue;
 			}
-
-			szCel = "BL";
-			pData = p->_pBData;
-			pAnim = (BYTE *)p->_pBAnim;
+			ppData = &p->_pBData;
+			pAnim = p->_pBAnim;
 			break;
 		default:
 			app_fatal("PLR:2");
 			break;
 		}
 
-		sprintf(pszName, "PlrGFX\\%s\\%s\\%s%s.CL2", cs, prefix, prefix, szCel);
-		LoadFileWithMem(pszName, pData);
-		SetPlayerGPtrs((BYTE *)pData, (BYTE **)pAnim);
+		if (!GetPlrGFXName(pszName, p->_pClass, p->_pgfxnum, leveltype == DTYPE_TOWN, (player_graphic)i)) {
+			continue;
+		}
+
+		// the running animation follows to the new file, as it did when the set was loaded in place
+		for (d = 0; d < 8; d++) {
+			if (*ppData != NULL && p->_pAnimData == pAnim[d])
+				break;
+		}
+		pData = LoadFileView(pszName, NULL);
+		MemFreeView(*ppData);
+		*ppData = pData;
+		SetPlayerGPtrs(pData, pAnim);
+		if (d < 8)
+			p->_pAnimData = pAnim[d];
 		p->_pGFXLoad |= i;
 	}
 }
@@ -263,114 +290,8 @@ void InitPlrGFXMem(int pnum)
 		app_fatal("InitPlrGFXMem: illegal player %d", pnum);
 	}
 
-	if (!(plr_gfx_flag & 0x1)) { //STAND
-		plr_gfx_flag |= 0x1;
-		if (GetPlrGFXSize("ST") > GetPlrGFXSize("AS")) {
-			plr_sframe_size = GetPlrGFXSize("ST"); //TOWN
-		} else {
-			plr_sframe_size = GetPlrGFXSize("AS"); //DUNGION
-		}
-	}
-	plr[pnum]._pNData = DiabloAllocPtr(plr_sframe_size);
-
-	if (!(plr_gfx_flag & 0x2)) { //WALK
-		plr_gfx_flag |= 0x2;
-		if (GetPlrGFXSize("WL") > GetPlrGFXSize("AW")) {
-			plr_wframe_size = GetPlrGFXSize("WL"); //TOWN
-		} else {
-			plr_wframe_size = GetPlrGFXSize("AW"); //DUNGION
-		}
-	}
-	plr[pnum]._pWData = DiabloAllocPtr(plr_wframe_size);
-
-	if (!(plr_gfx_flag & 0x4)) { //ATTACK
-		plr_gfx_flag |= 0x4;
-		plr_aframe_size = GetPlrGFXSize("AT");
-	}
-	plr[pnum]._pAData = DiabloAllocPtr(plr_aframe_size);
-
-	if (!(plr_gfx_flag & 0x8)) { //HIT
-		plr_gfx_flag |= 0x8;
-		plr_hframe_size = GetPlrGFXSize("HT");
-	}
-	plr[pnum]._pHData = DiabloAllocPtr(plr_hframe_size);
-
-	if (!(plr_gfx_flag & 0x10)) { //LIGHTNING
-		plr_gfx_flag |= 0x10;
-		plr_lframe_size = GetPlrGFXSize("LM");
-	}
-	plr[pnum]._pLData = DiabloAllocPtr(plr_lframe_size);
-
-	if (!(plr_gfx_flag & 0x20)) { //FIRE
-		plr_gfx_flag |= 0x20;
-		plr_fframe_size = GetPlrGFXSize("FM");
-	}
-	plr[pnum]._pFData = DiabloAllocPtr(plr_fframe_size);
-
-	if (!(plr_gfx_flag & 0x40)) { //MAGIC
-		plr_gfx_flag |= 0x40;
-		plr_qframe_size = GetPlrGFXSize("QM");
-	}
-	plr[pnum]._pTData = DiabloAllocPtr(plr_qframe_size);
-
-	if (!(plr_gfx_flag & 0x80)) { //DEATH
-		plr_gfx_flag |= 0x80;
-		plr_dframe_size = GetPlrGFXSize("DT");
-	}
-	plr[pnum]._pDData = DiabloAllocPtr(plr_dframe_size);
-
-	if (!(plr_gfx_bflag & 0x1)) { //BLOCK
-		plr_gfx_bflag |= 0x1;
-		plr_bframe_size = GetPlrGFXSize("BL");
-	}
-	plr[pnum]._pBData = DiabloAllocPtr(plr_bframe_size);
-
-	plr[pnum]._pGFXLoad = 0;
-}
-
-DWORD GetPlrGFXSize(char *szCel)
-{
-	int c;
-	const char *a, *w;
-	DWORD dwSize, dwMaxSize;
-	HANDLE hsFile;
-	char pszName[256];
-	char Type[16];
-
-	dwMaxSize = 0;
-
-	for (c = 0; c < sizeof(ClassStrTbl) / sizeof(*ClassStrTbl); c++) {
-#ifdef SPAWN
-		if (c != 0)
-			continue;
-#endif
-		for (a = &ArmourChar[0]; *a; a++) {
-#ifdef SPAWN
-			if (a != &ArmourChar[0])
-				break;
-#endif
-			for (w = &WepChar[0]; *w; w++) {
-				if (szCel[0] == 'D' && szCel[1] == 'T' && *w != 'N') {
-					continue; //Death has no weapon
-				}
-				if (szCel[0] == 'B' && szCel[1] == 'L' && (*w != 'U' && *w != 'D' && *w != 'H')) {
-					continue; //No block without weapon
-				}
-				sprintf(Type, "%c%c%c", CharChar[c], *a, *w);
-				sprintf(pszName, "PlrGFX\\%s\\%s\\%s%s.CL2", ClassStrTbl[c], Type, Type, szCel);
-				if (WOpenFile(pszName, &hsFile, TRUE)) {
-					/// ASSERT: assert(hsFile);
-					dwSize = WGetFileSize(hsFile, NULL, pszName);
-					WCloseFile(hsFile);
-					if (dwMaxSize <= dwSize) {
-						dwMaxSize = dwSize;
-					}
-				}
-			}
-		}
-	}
-
-	return dwMaxSize;
+	// the animations are file views taken by LoadPlrGFX, nothing is reserved up front
+	FreePlayerGFX(pnum);
 }
 
 void FreePlayerGFX(int pnum)
@@ -379,15 +300,16 @@ void FreePlayerGFX(int pnum)
 		app_fatal("FreePlayerGFX: illegal player %d", pnum);
 	}
 
-	MemFreeDbg(plr[pnum]._pNData);
-	MemFreeDbg(plr[pnum]._pWData);
-	MemFreeDbg(plr[pnum]._pAData);
-	MemFreeDbg(plr[pnum]._pHData);
-	MemFreeDbg(plr[pnum]._pLData);
-	MemFreeDbg(plr[pnum]._pFData);
-	MemFreeDbg(plr[pnum]._pTData);
-	MemFreeDbg(plr[pnum]._pDData);
-	MemFreeDbg(plr[pnum]._pBData);
+	plrgfx_cancel(pnum);
+	MemFreeView(plr[pnum]._pNData);
+	MemFreeView(plr[pnum]._pWData);
+	MemFreeView(plr[pnum]._pAData);
+	MemFreeView(plr[pnum]._pHData);
+	MemFreeView(plr[pnum]._pLData);
+	MemFreeView(plr[pnum]._pFData);
+	MemFreeView(plr[pnum]._pTData);
+	MemFreeView(plr[pnum]._pDData);
+	MemFreeView(plr[pnum]._pBData);
 	plr[pnum]._pGFXLoad = 0;
 }
 
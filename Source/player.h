@@ -2,27 +2,16 @@
 #ifndef __PLAYER_H__
 #define __PLAYER_H__
 
-extern int plr_lframe_size;
-extern int plr_wframe_size;
-extern BYTE plr_gfx_flag;
-extern int plr_aframe_size;
 extern int myplr;
 extern PlayerStruct plr[MAX_PLRS];
-extern int plr_fframe_size;
-extern int plr_qframe_size;
 extern BOOL deathflag;
-extern int plr_hframe_size;
-extern int plr_bframe_size;
-extern BYTE plr_gfx_bflag;
-extern int plr_sframe_size;
 extern int deathdelay;
-extern int plr_dframe_size;
 
 void SetPlayerGPtrs(BYTE *pData, BYTE **pAnim);
+BOOL GetPlrGFXName(char *pszName, int pc, int gfxnum, BOOL town, player_graphic gfx);
 void LoadPlrGFX(int pnum, player_graphic gfxflag);
 void InitPlayerGFX(int pnum);
 void InitPlrGFXMem(int pnum);
-DWORD GetPlrGFXSize(char *szCel);
 void FreePlayerGFX(int pnum);
 void NewPlrAnim(int pnum, BYTE *Peq, int numFrames, int Delay, int width);
 void ClearPlrPVars(int pnum);
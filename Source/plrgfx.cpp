@@ -0,0 +1,379 @@
+#include "diablo.h"
+#include "../3rdParty/Storm/Source/storm.h"
+
+DEVILUTION_BEGIN_NAMESPACE
+
+/** The animation files of one armour and weapon combination, for town or the dungeon */
+typedef struct PlrGfxSet {
+	BOOLEAN bLoaded;
+	BOOLEAN bTown;
+	int nGfxNum;
+	DWORD dwLastUse;
+	/** Indexed by the bit number of the player_graphic, NULL where the set has no such file */
+	BYTE *pData[NUM_PLRGFX_FILES];
+} PlrGfxSet;
+
+/** A set the loader thread works on for one player */
+typedef struct PlrGfxJob {
+	/** Waiting for the loader thread */
+	BOOLEAN bQueued;
+	/** Loaded, waiting for the game thread to cache it */
+	BOOLEAN bDone;
+	BOOLEAN bBlock;
+	int nClass;
+	/** Bumped when the job is dropped, a set loaded for an older request is released */
+	DWORD dwGen;
+	PlrGfxSet set;
+} PlrGfxJob;
+
+/** Protects the jobs, the cache is only used by the game thread */
+static SDL_mutex *sgpPlrGfxMutex;
+/** Signalled when a job is queued */
+static SDL_cond *sgpPlrGfxWork;
+/** Signalled when the loader thread is done with a job */
+static SDL_cond *sgpPlrGfxDone;
+static PlrGfxJob sgPlrGfxJobs[MAX_PLRS];
+/** Player whose set the loader thread is loading outside the lock, -1 for none */
+static int sgnPlrGfxBusy = -1;
+/** The player has a request out, only touched by the game thread */
+static BOOLEAN sgbPlrGfxPending[MAX_PLRS];
+/** Recently used sets of each class, they hold their files so switching back is immediate */
+static PlrGfxSet sgPlrGfxCache[NUM_CLASSES][MAX_PLRGFX_SETS];
+static int sgnPlrGfxSets;
+static DWORD sgdwPlrGfxClock;
+static BOOLEAN sgbPlrGfxInit;
+static BOOLEAN sgbPlrGfxThread;
+/** Set by plrgfx_cleanup, the thread returns once it is done with the set in progress */
+static BOOLEAN sgbPlrGfxQuit;
+static HANDLE sghPlrGfxThread;
+static unsigned int sgdwPlrGfxThreadId;
+
+/**
+ * @brief Read the "Player Graphics Sets" setting and start the loader thread
+ */
+static void plrgfx_init()
+{
+	int value;
+
+	sgbPlrGfxInit = TRUE;
+	value = 4;
+	if (!SRegLoadValue("devilutionx", "Player Graphics Sets", 0, &value))
+		SRegSaveValue("devilutionx", "Player Graphics Sets", 0, value);
+	if (value <= 0)
+		return;
+	sgnPlrGfxSets = value < MAX_PLRGFX_SETS ? value : MAX_PLRGFX_SETS;
+#if defined(VITA) || defined(__AMIGA__)
+	// StormLib seeks and reads the archive there, which can't be shared between threads
+	return;
+#endif
+
+	sgpPlrGfxMutex = SDL_CreateMutex();
+	sgpPlrGfxWork = SDL_CreateCond();
+	sgpPlrGfxDone = SDL_CreateCond();
+	if (sgpPlrGfxMutex == NULL || sgpPlrGfxWork == NULL || sgpPlrGfxDone == NULL)
+		app_fatal("plrgfx1:\n%s", TraceLastError());
+	sgbPlrGfxQuit = FALSE;
+	sghPlrGfxThread = (HANDLE)_beginthreadex(NULL, 0, plrgfx_handler, NULL, 0, &sgdwPlrGfxThreadId);
+	if (sghPlrGfxThread == INVALID_HANDLE_VALUE)
+		app_fatal("plrgfx2:\n%s", TraceLastError());
+	sgbPlrGfxThread = TRUE;
+}
+
+/**
+ * @brief Load every file of a set but the death animation, which doesn't depend on gear
+ */
+static void plrgfx_load(PlrGfxSet *set, int pc, BOOL block)
+{
+	char szName[256];
+	DWORD gfx;
+	int i;
+
+	for (i = 0, gfx = 1; i < NUM_PLRGFX_FILES; i++, gfx <<= 1) {
+		set->pData[i] = NULL;
+		if (gfx == PFILE_DEATH || gfx == PFILE_BLOCK && !block)
+			continue;
+		if (GetPlrGFXName(szName, pc, set->nGfxNum, set->bTown, (player_graphic)gfx))
+			set->pData[i] = LoadFileView(szName, NULL);
+	}
+	set->bLoaded = TRUE;
+}
+
+static void plrgfx_release(PlrGfxSet *set)
+{
+	int i;
+
+	for (i = 0; i < NUM_PLRGFX_FILES; i++)
+		MemFreeView(set->pData[i]);
+	set->bLoaded = FALSE;
+}
+
+static PlrGfxSet *plrgfx_find(int pc, int gfxnum, BOOL town)
+{
+	int i;
+
+	for (i = 0; i < sgnPlrGfxSets; i++) {
+		if (sgPlrGfxCache[pc][i].bLoaded && sgPlrGfxCache[pc][i].nGfxNum == gfxnum && sgPlrGfxCache[pc][i].bTown == town)
+			return &sgPlrGfxCache[pc][i];
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Add a loaded set to the cache of its class, pushing out the least recently used one
+ */
+static void plrgfx_store(int pc, PlrGfxSet *set)
+{
+	PlrGfxSet *slot;
+	int i;
+
+	slot = plrgfx_find(pc, set->nGfxNum, set->bTown);
+	if (slot != NULL) {
+		// two players asked for the same gear at once
+		plrgfx_release(set);
+	} else {
+		slot = &sgPlrGfxCache[pc][0];
+		for (i = 0; i < sgnPlrGfxSets && slot->bLoaded; i++) {
+			if (!sgPlrGfxCache[pc][i].bLoaded || sgPlrGfxCache[pc][i].dwLastUse < slot->dwLastUse)
+				slot = &sgPlrGfxCache[pc][i];
+		}
+		if (slot->bLoaded)
+			plrgfx_release(slot);
+		*slot = *set;
+	}
+	slot->dwLastUse = ++sgdwPlrGfxClock;
+}
+
+/**
+ * @brief Cache a set the loader thread is done with
+ *
+ * Nothing about the player changes here, LoadPlrGFX picks the files up from
+ * the cache when the animations are first played.
+ */
+static void plrgfx_collect(int pnum)
+{
+	PlrGfxJob *job;
+	PlrGfxSet set;
+	BOOL done;
+	int pc;
+
+	job = &sgPlrGfxJobs[pnum];
+	SDL_LockMutex(sgpPlrGfxMutex);
+	done = job->bDone;
+	if (done) {
+		set = job->set;
+		pc = job->nClass;
+		job->bDone = FALSE;
+	}
+	SDL_UnlockMutex(sgpPlrGfxMutex);
+	if (!done)
+		return;
+
+	sgbPlrGfxPending[pnum] = FALSE;
+	plrgfx_store(pc, &set);
+}
+
+/**
+ * @brief Stage the animation files of the player's new gear
+ *
+ * Called after an equipment change has loaded the stand animation and reset
+ * the player's animation, so the game state never waits on the loader thread.
+ * The other files of the set are loaded in the background, gear that was worn
+ * recently is still cached.
+ * @param pnum Player index
+ */
+void plrgfx_request(int pnum)
+{
+	PlayerStruct *p;
+	PlrGfxSet *set;
+	PlrGfxJob *job;
+	BOOL town;
+
+	if (!sgbPlrGfxInit)
+		plrgfx_init();
+
+	p = &plr[pnum];
+	town = leveltype == DTYPE_TOWN;
+	plrgfx_cancel(pnum);
+	if (sgnPlrGfxSets == 0)
+		return;
+
+	set = plrgfx_find(p->_pClass, p->_pgfxnum, town);
+	if (set != NULL) {
+		set->dwLastUse = ++sgdwPlrGfxClock;
+		return;
+	}
+
+	job = &sgPlrGfxJobs[pnum];
+	if (!sgbPlrGfxThread) {
+		job->set.nGfxNum = p->_pgfxnum;
+		job->set.bTown = town;
+		plrgfx_load(&job->set, p->_pClass, p->_pBlockFlag);
+		plrgfx_store(p->_pClass, &job->set);
+		return;
+	}
+
+	SDL_LockMutex(sgpPlrGfxMutex);
+	job->nClass = p->_pClass;
+	job->bBlock = p->_pBlockFlag;
+	job->set.nGfxNum = p->_pgfxnum;
+	job->set.bTown = town;
+	job->bQueued = TRUE;
+	SDL_CondSignal(sgpPlrGfxWork);
+	SDL_UnlockMutex(sgpPlrGfxMutex);
+	sgbPlrGfxPending[pnum] = TRUE;
+}
+
+/**
+ * @brief Wait for the player's requested set, so LoadPlrGFX doesn't load its files a second time
+ * @param pnum Player index
+ */
+void plrgfx_finish(int pnum)
+{
+	PlrGfxJob *job;
+
+	if (!sgbPlrGfxPending[pnum])
+		return;
+
+	job = &sgPlrGfxJobs[pnum];
+	SDL_LockMutex(sgpPlrGfxMutex);
+	while (job->bQueued || sgnPlrGfxBusy == pnum)
+		SDL_CondWait(sgpPlrGfxDone, sgpPlrGfxMutex);
+	SDL_UnlockMutex(sgpPlrGfxMutex);
+	plrgfx_collect(pnum);
+}
+
+/**
+ * @brief Drop the player's request, a set still being loaded is released by the loader thread
+ * @param pnum Player index
+ */
+void plrgfx_cancel(int pnum)
+{
+	PlrGfxJob *job;
+
+	if (!sgbPlrGfxPending[pnum])
+		return;
+
+	job = &sgPlrGfxJobs[pnum];
+	SDL_LockMutex(sgpPlrGfxMutex);
+	job->dwGen++;
+	job->bQueued = FALSE;
+	if (job->bDone) {
+		plrgfx_release(&job->set);
+		job->bDone = FALSE;
+	}
+	SDL_UnlockMutex(sgpPlrGfxMutex);
+	sgbPlrGfxPending[pnum] = FALSE;
+}
+
+/**
+ * @brief Cache the sets the loader thread has finished, called every game tick
+ */
+void plrgfx_update()
+{
+	int i;
+
+	for (i = 0; i < MAX_PLRS; i++) {
+		if (sgbPlrGfxPending[i])
+			plrgfx_collect(i);
+	}
+}
+
+/**
+ * @brief Drop every request and stop the loader thread, before the archives are closed
+ *
+ * The next plrgfx_request starts the thread again.
+ */
+void plrgfx_cleanup()
+{
+	int i;
+
+	for (i = 0; i < MAX_PLRS; i++)
+		plrgfx_cancel(i);
+
+	sgbPlrGfxInit = FALSE;
+	if (!sgbPlrGfxThread)
+		return;
+	// app_fatal on the loader thread itself, it can't wait for itself
+	if (sgdwPlrGfxThreadId == GetCurrentThreadId())
+		return;
+
+	SDL_LockMutex(sgpPlrGfxMutex);
+	sgbPlrGfxQuit = TRUE;
+	SDL_CondSignal(sgpPlrGfxWork);
+	SDL_UnlockMutex(sgpPlrGfxMutex);
+	if (WaitForSingleObject(sghPlrGfxThread, 0xFFFFFFFF) == -1)
+		app_fatal("plrgfx3:\n(%s)", TraceLastError());
+	CloseHandle(sghPlrGfxThread);
+	sghPlrGfxThread = INVALID_HANDLE_VALUE;
+
+	sgbPlrGfxThread = FALSE;
+	SDL_DestroyCond(sgpPlrGfxWork);
+	SDL_DestroyCond(sgpPlrGfxDone);
+	SDL_DestroyMutex(sgpPlrGfxMutex);
+	sgpPlrGfxWork = NULL;
+	sgpPlrGfxDone = NULL;
+	sgpPlrGfxMutex = NULL;
+}
+
+/**
+ * @brief Stop loading and let go of the cached sets when the game ends
+ */
+void plrgfx_free()
+{
+	int pc, i;
+
+	plrgfx_cleanup();
+
+	for (pc = 0; pc < NUM_CLASSES; pc++) {
+		for (i = 0; i < MAX_PLRGFX_SETS; i++) {
+			if (sgPlrGfxCache[pc][i].bLoaded)
+				plrgfx_release(&sgPlrGfxCache[pc][i]);
+		}
+	}
+}
+
+unsigned int __stdcall plrgfx_handler(void *)
+{
+	PlrGfxSet set;
+	PlrGfxJob *job;
+	DWORD gen;
+	int pnum, pc;
+	BOOL block;
+
+	SDL_LockMutex(sgpPlrGfxMutex);
+	while (!sgbPlrGfxQuit) {
+		for (pnum = 0; pnum < MAX_PLRS && !sgPlrGfxJobs[pnum].bQueued; pnum++)
+			;
+		if (pnum == MAX_PLRS) {
+			SDL_CondWait(sgpPlrGfxWork, sgpPlrGfxMutex);
+			continue;
+		}
+
+		job = &sgPlrGfxJobs[pnum];
+		job->bQueued = FALSE;
+		set = job->set;
+		pc = job->nClass;
+		block = job->bBlock;
+		gen = job->dwGen;
+		sgnPlrGfxBusy = pnum;
+		SDL_UnlockMutex(sgpPlrGfxMutex);
+
+		plrgfx_load(&set, pc, block);
+
+		SDL_LockMutex(sgpPlrGfxMutex);
+		sgnPlrGfxBusy = -1;
+		if (gen == job->dwGen) {
+			job->set = set;
+			job->bDone = TRUE;
+		} else {
+			plrgfx_release(&set);
+		}
+		SDL_CondSignal(sgpPlrGfxDone);
+	}
+	SDL_UnlockMutex(sgpPlrGfxMutex);
+
+	return 0;
+}
+
+DEVILUTION_END_NAMESPACE
@@ -0,0 +1,13 @@
+//HEADER_GOES_HERE
+#ifndef __PLRGFX_H__
+#define __PLRGFX_H__
+
+void plrgfx_request(int pnum);
+void plrgfx_finish(int pnum);
+void plrgfx_cancel(int pnum);
+void plrgfx_update();
+void plrgfx_cleanup();
+void plrgfx_free();
+unsigned int __stdcall plrgfx_handler(void *);
+
+#endif /* __PLRGFX_H__ */
@@ -0,0 +1,321 @@
+#include "diablo.h"
+#include "../3rdParty/Storm/Source/storm.h"
+
+DEVILUTION_BEGIN_NAMESPACE
+
+/** Protects everything below that the prefetch thread also touches */
+static SDL_mutex *sgpPrefetchMutex;
+/** Signalled when files are queued */
+static SDL_cond *sgpPrefetchWork;
+/** Signalled when the prefetch thread is done with a file */
+static SDL_cond *sgpPrefetchDone;
+/** Files to stage for the current target, the thread takes them in order */
+static char sgszPrefetchFiles[MAX_PREFETCH_FILES][MAX_PATH];
+static int sgnPrefetchFiles;
+static int sgnPrefetchNext;
+/** Views staged for the current target, held until that level is loaded */
+static BYTE *sgpPrefetchViews[MAX_PREFETCH_FILES];
+static int sgnPrefetchViews;
+/** The thread is loading a file outside the lock */
+static BOOLEAN sgbPrefetchBusy;
+/** Bumped on every target change, a file loaded for an older target is dropped */
+static DWORD sgdwPrefetchGen;
+/** Level being staged, -1 for none */
+static int sgnPrefetchLevel = -1;
+static BOOLEAN sgbPrefetchInit;
+static BOOLEAN sgbPrefetchThread;
+/** Set by prefetch_cleanup, the thread returns once it is done with the file in progress */
+static BOOLEAN sgbPrefetchQuit;
+static HANDLE sghPrefetchThread;
+static unsigned int sgdwPrefetchThreadId;
+/** Monster types of each level as of its last load, staged again on a revisit */
+static BYTE sgLevelMTypes[NUMLEVELS][MAX_LVLMTYPES];
+static int sgnLevelMTypes[NUMLEVELS];
+
+/**
+ * @brief Read the "Prefetch Levels" setting and start the prefetch thread
+ */
+static void prefetch_init()
+{
+	int value;
+
+	sgbPrefetchInit = TRUE;
+#if defined(VITA) || defined(__AMIGA__)
+	// StormLib seeks and reads the archive there, which can't be shared between threads
+	return;
+#endif
+	value = 1;
+	if (!SRegLoadValue("devilutionx", "Prefetch Levels", 0, &value))
+		SRegSaveValue("devilutionx", "Prefetch Levels", 0, value);
+	if (value == 0)
+		return;
+
+	sgpPrefetchMutex = SDL_CreateMutex();
+	sgpPrefetchWork = SDL_CreateCond();
+	sgpPrefetchDone = SDL_CreateCond();
+	if (sgpPrefetchMutex == NULL || sgpPrefetchWork == NULL || sgpPrefetchDone == NULL)
+		app_fatal("prefetch1:\n%s", TraceLastError());
+	sgbPrefetchQuit = FALSE;
+	sghPrefetchThread = (HANDLE)_beginthreadex(NULL, 0, prefetch_handler, NULL, 0, &sgdwPrefetchThreadId);
+	if (sghPrefetchThread == INVALID_HANDLE_VALUE)
+		app_fatal("prefetch2:\n%s", TraceLastError());
+	sgbPrefetchThread = TRUE;
+}
+
+/**
+ * @brief Find the level the player is likely to enter next
+ *
+ * Looks for stairs and warps within PREFETCH_RADIUS of the player, then for
+ * open town portals.
+ * @param lvl Receives the level number
+ * @param ltype Receives the level type
+ * @return TRUE if a level exit is near
+ */
+static BOOL prefetch_find_target(int *lvl, int *ltype)
+{
+	int i, mi, src;
+	PlayerStruct *p;
+
+	p = &plr[myplr];
+	for (i = 0; i < numtrigs; i++) {
+		if (abs(p->WorldX - trigs[i]._tx) > PREFETCH_RADIUS || abs(p->WorldY - trigs[i]._ty) > PREFETCH_RADIUS)
+			continue;
+
+		switch (trigs[i]._tmsg) {
+		case WM_DIABNEXTLVL:
+			*lvl = currlevel + 1;
+			break;
+		case WM_DIABPREVLVL:
+			*lvl = currlevel - 1;
+			break;
+		case WM_DIABTOWNWARP:
+			*lvl = trigs[i]._tlvl;
+			break;
+		case WM_DIABTWARPUP:
+			*lvl = 0;
+			break;
+		case WM_DIABRTNLVL:
+			*lvl = ReturnLvl;
+			break;
+		default:
+			continue;
+		}
+		if (*lvl < 0 || *lvl >= NUMLEVELS)
+			continue;
+		*ltype = gnLevelTypeTbl[*lvl];
+		return TRUE;
+	}
+
+	for (i = 0; i < nummissiles; i++) {
+		mi = missileactive[i];
+		if (missile[mi]._mitype != MIS_TOWN)
+			continue;
+		if (abs(p->WorldX - missile[mi]._mix) > PREFETCH_RADIUS || abs(p->WorldY - missile[mi]._miy) > PREFETCH_RADIUS)
+			continue;
+
+		if (leveltype != DTYPE_TOWN) {
+			*lvl = 0;
+			*ltype = DTYPE_TOWN;
+			return TRUE;
+		}
+		src = missile[mi]._misource;
+		if (portal[src].setlvl)
+			continue;
+		*lvl = portal[src].level;
+		*ltype = portal[src].ltype;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * @brief Drop the staged views and whatever is still queued, lock must be held
+ */
+static void prefetch_clear()
+{
+	int i;
+
+	sgdwPrefetchGen++;
+	sgnPrefetchFiles = 0;
+	sgnPrefetchNext = 0;
+	for (i = 0; i < sgnPrefetchViews; i++)
+		ReleaseFileView(sgpPrefetchViews[i]);
+	sgnPrefetchViews = 0;
+	sgnPrefetchLevel = -1;
+}
+
+static void prefetch_queue(const char *pszName)
+{
+	if (sgnPrefetchFiles < MAX_PREFETCH_FILES)
+		SStrCopy(sgszPrefetchFiles[sgnPrefetchFiles++], pszName, MAX_PATH);
+}
+
+/**
+ * @brief Stage the tiles of the given level, and its monsters if it was visited before
+ */
+static void prefetch_start(int lvl, int ltype)
+{
+	int i, anim, mtype;
+	char szName[MAX_PATH];
+
+	SDL_LockMutex(sgpPrefetchMutex);
+	prefetch_clear();
+	sgnPrefetchLevel = lvl;
+
+#ifdef SPAWN
+	if (ltype == DTYPE_TOWN || ltype == DTYPE_CATHEDRAL) {
+#else
+	if (ltype <= DTYPE_HELL) {
+#endif
+		for (i = 0; i < 4; i++)
+			prefetch_queue(LvlGFXFiles[ltype][i]);
+	}
+
+	// same files InitMonsterGFX loads
+	for (i = 0; i < sgnLevelMTypes[lvl]; i++) {
+		mtype = sgLevelMTypes[lvl][i];
+		for (anim = 0; anim < 6; anim++) {
+			if ((animletter[anim] != 's' || monsterdata[mtype].has_special) && monsterdata[mtype].Frames[anim] > 0) {
+				sprintf(szName, monsterdata[mtype].GraphicType, animletter[anim]);
+				prefetch_queue(szName);
+			}
+		}
+	}
+
+	SDL_CondSignal(sgpPrefetchWork);
+	SDL_UnlockMutex(sgpPrefetchMutex);
+}
+
+/**
+ * @brief Start staging the next level once the player gets near an exit, called every game tick
+ */
+void prefetch_update()
+{
+	int lvl, ltype;
+
+	if (!sgbPrefetchInit)
+		prefetch_init();
+	if (!sgbPrefetchThread)
+		return;
+
+	// keep what is staged when walking away, the player may well turn back
+	if (!prefetch_find_target(&lvl, &ltype) || lvl == sgnPrefetchLevel)
+		return;
+	if (!setlevel && lvl == currlevel)
+		return;
+
+	prefetch_start(lvl, ltype);
+}
+
+/**
+ * @brief Wait for the prefetch thread before a level is loaded
+ *
+ * When the level being loaded is the one being staged the remaining files are
+ * loaded first, they would be needed right away anyway. Otherwise the queue is
+ * dropped and only the file in progress is waited for.
+ * @param lvl The level about to be loaded, -1 for a quest level
+ */
+void prefetch_wait(int lvl)
+{
+	if (!sgbPrefetchThread)
+		return;
+
+	SDL_LockMutex(sgpPrefetchMutex);
+	if (lvl != sgnPrefetchLevel)
+		prefetch_clear();
+	while (sgbPrefetchBusy || sgnPrefetchNext < sgnPrefetchFiles)
+		SDL_CondWait(sgpPrefetchDone, sgpPrefetchMutex);
+	SDL_UnlockMutex(sgpPrefetchMutex);
+}
+
+/**
+ * @brief Remember the monsters of the level just loaded and let go of the staged files
+ *
+ * The level holds its own references by now, staged files it didn't use go
+ * to the file view cache.
+ */
+void prefetch_level_loaded()
+{
+	int i;
+
+	if (!setlevel) {
+		for (i = 0; i < nummtypes && i < MAX_LVLMTYPES; i++)
+			sgLevelMTypes[currlevel][i] = Monsters[i].mtype;
+		sgnLevelMTypes[currlevel] = i;
+	}
+
+	if (!sgbPrefetchThread)
+		return;
+
+	SDL_LockMutex(sgpPrefetchMutex);
+	prefetch_clear();
+	SDL_UnlockMutex(sgpPrefetchMutex);
+}
+
+/**
+ * @brief Stop the prefetch thread and drop what it staged, before the archives are closed
+ *
+ * The next prefetch_update starts the thread again.
+ */
+void prefetch_cleanup()
+{
+	sgbPrefetchInit = FALSE;
+	if (!sgbPrefetchThread)
+		return;
+	// app_fatal on the prefetch thread itself, it can't wait for itself
+	if (sgdwPrefetchThreadId == GetCurrentThreadId())
+		return;
+
+	SDL_LockMutex(sgpPrefetchMutex);
+	prefetch_clear();
+	sgbPrefetchQuit = TRUE;
+	SDL_CondSignal(sgpPrefetchWork);
+	SDL_UnlockMutex(sgpPrefetchMutex);
+	if (WaitForSingleObject(sghPrefetchThread, 0xFFFFFFFF) == -1)
+		app_fatal("prefetch3:\n(%s)", TraceLastError());
+	CloseHandle(sghPrefetchThread);
+	sghPrefetchThread = INVALID_HANDLE_VALUE;
+
+	sgbPrefetchThread = FALSE;
+	SDL_DestroyCond(sgpPrefetchWork);
+	SDL_DestroyCond(sgpPrefetchDone);
+	SDL_DestroyMutex(sgpPrefetchMutex);
+	sgpPrefetchWork = NULL;
+	sgpPrefetchDone = NULL;
+	sgpPrefetchMutex = NULL;
+}
+
+unsigned int __stdcall prefetch_handler(void *)
+{
+	char szName[MAX_PATH];
+	DWORD gen;
+	BYTE *view;
+
+	SDL_LockMutex(sgpPrefetchMutex);
+	while (TRUE) {
+		while (sgnPrefetchNext >= sgnPrefetchFiles && !sgbPrefetchQuit)
+			SDL_CondWait(sgpPrefetchWork, sgpPrefetchMutex);
+		if (sgbPrefetchQuit)
+			break;
+		SStrCopy(szName, sgszPrefetchFiles[sgnPrefetchNext++], MAX_PATH);
+		gen = sgdwPrefetchGen;
+		sgbPrefetchBusy = TRUE;
+		SDL_UnlockMutex(sgpPrefetchMutex);
+
+		view = LoadFileView(szName, NULL);
+
+		SDL_LockMutex(sgpPrefetchMutex);
+		sgbPrefetchBusy = FALSE;
+		if (gen == sgdwPrefetchGen)
+			sgpPrefetchViews[sgnPrefetchViews++] = view;
+		else
+			ReleaseFileView(view);
+		SDL_CondSignal(sgpPrefetchDone);
+	}
+	SDL_UnlockMutex(sgpPrefetchMutex);
+
+	return 0;
+}
+
+DEVILUTION_END_NAMESPACE
@@ -0,0 +1,11 @@
+//HEADER_GOES_HERE
+#ifndef __PREFETCH_H__
+#define __PREFETCH_H__
+
+void prefetch_update();
+void prefetch_wait(int lvl);
+void prefetch_level_loaded();
+void prefetch_cleanup();
+unsigned int __stdcall prefetch_handler(void *);
+
+#endif /* __PREFETCH_H__ */
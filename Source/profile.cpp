@@ -0,0 +1,245 @@
+#include "diablo.h"
+#include "../3rdParty/Storm/Source/storm.h"
+
+DEVILUTION_BEGIN_NAMESPACE
+
+/** Names of the timed zones, also the CSV column headers */
+static const char *const ProfileZoneNames[NUM_PROFILE_ZONES] = {
+	"ProcessPlayers",
+	"ProcessMonsters",
+	"ProcessObjects",
+	"ProcessMissiles",
+	"ProcessItems",
+	"ProcessLightList",
+	"ProcessVisionList",
+	"multi_process_network_packets",
+	"DrawGame",
+	"DrawView",
+	"RenderPresent",
+};
+
+/** 0 off, 1 overlay, 2 overlay and CSV dump */
+static int sgnProfileMode;
+static BOOLEAN sgbProfileInit;
+/** Start of the running zones, 0 when not running */
+static unsigned long long sgProfileStart[NUM_PROFILE_ZONES];
+/** Time spent in each zone during the current frame */
+static DWORD sgdwProfileFrame[NUM_PROFILE_ZONES];
+static BOOLEAN sgbProfileHit[NUM_PROFILE_ZONES];
+/** Rolling samples, one per frame a zone ran in, the last slot is the whole frame */
+static DWORD sgdwProfileSamples[NUM_PROFILE_ZONES + 1][PROFILE_FRAMES];
+static int sgnProfileSamples[NUM_PROFILE_ZONES + 1];
+static int sgnProfileNext[NUM_PROFILE_ZONES + 1];
+/** Percentiles shown by the overlay, refreshed once a second */
+static DWORD sgdwProfileP50[NUM_PROFILE_ZONES + 1];
+static DWORD sgdwProfileP95[NUM_PROFILE_ZONES + 1];
+static DWORD sgdwProfileP99[NUM_PROFILE_ZONES + 1];
+static DWORD sgdwProfileUpdated;
+static unsigned long long sgProfileFrameStart;
+static DWORD sgdwProfileFrameNum;
+static FILE *sgpProfileFile;
+static BOOLEAN sgbProfileHeader;
+
+/**
+ * @brief Current time in microseconds
+ */
+static unsigned long long profile_now()
+{
+#ifdef USE_SDL1
+	return (unsigned long long)SDL_GetTicks() * 1000;
+#else
+	unsigned long long c, f;
+
+	// split up so the multiplication can't overflow, c * 1000000 would after hours of uptime
+	c = SDL_GetPerformanceCounter();
+	f = SDL_GetPerformanceFrequency();
+	return c / f * 1000000 + c % f * 1000000 / f;
+#endif
+}
+
+/**
+ * @brief Read the "Profiler" setting
+ */
+static void profile_init()
+{
+	sgbProfileInit = TRUE;
+	sgnProfileMode = 0;
+	if (!SRegLoadValue("devilutionx", "Profiler", 0, &sgnProfileMode))
+		SRegSaveValue("devilutionx", "Profiler", 0, sgnProfileMode);
+}
+
+/**
+ * @brief Start timing a zone
+ * @param zone profile_zone
+ */
+void profile_begin(int zone)
+{
+	if (!sgbProfileInit)
+		profile_init();
+	if (sgnProfileMode == 0)
+		return;
+
+	sgProfileStart[zone] = profile_now();
+}
+
+/**
+ * @brief Stop timing a zone and add the time to the current frame
+ * @param zone profile_zone
+ */
+void profile_end(int zone)
+{
+	if (sgnProfileMode == 0 || sgProfileStart[zone] == 0)
+		return;
+
+	sgdwProfileFrame[zone] += (DWORD)(profile_now() - sgProfileStart[zone]);
+	sgbProfileHit[zone] = TRUE;
+	sgProfileStart[zone] = 0;
+}
+
+static void profile_add_sample(int i, DWORD value)
+{
+	sgdwProfileSamples[i][sgnProfileNext[i]] = value;
+	sgnProfileNext[i] = (sgnProfileNext[i] + 1) % PROFILE_FRAMES;
+	if (sgnProfileSamples[i] < PROFILE_FRAMES)
+		sgnProfileSamples[i]++;
+}
+
+static int profile_compare(const void *a, const void *b)
+{
+	DWORD x, y;
+
+	x = *(const DWORD *)a;
+	y = *(const DWORD *)b;
+	return x < y ? -1 : x > y;
+}
+
+static void profile_percentiles()
+{
+	int i, n;
+	DWORD sorted[PROFILE_FRAMES];
+
+	for (i = 0; i <= NUM_PROFILE_ZONES; i++) {
+		n = sgnProfileSamples[i];
+		if (n == 0)
+			continue;
+		memcpy(sorted, sgdwProfileSamples[i], n * sizeof(*sorted));
+		qsort(sorted, n, sizeof(*sorted), profile_compare);
+		sgdwProfileP50[i] = sorted[n * 50 / 100];
+		sgdwProfileP95[i] = sorted[n * 95 / 100];
+		sgdwProfileP99[i] = sorted[n * 99 / 100];
+	}
+}
+
+/**
+ * @brief Append the frame to profile.csv in the pref path, one column per zone in microseconds
+ */
+static void profile_write(DWORD frameTime)
+{
+	int i;
+	char path[MAX_PATH], csvPath[MAX_PATH];
+
+	if (sgpProfileFile == NULL) {
+		GetPrefPath(path, MAX_PATH);
+		snprintf(csvPath, MAX_PATH, "%sprofile.csv", path);
+		// a new file per run, later games in the same run go to the end of it
+		sgpProfileFile = fopen(csvPath, sgbProfileHeader ? "ab" : "wb");
+		if (sgpProfileFile == NULL) {
+			sgnProfileMode = 1;
+			return;
+		}
+		if (!sgbProfileHeader) {
+			fprintf(sgpProfileFile, "frame,level,frame_us");
+			for (i = 0; i < NUM_PROFILE_ZONES; i++)
+				fprintf(sgpProfileFile, ",%s", ProfileZoneNames[i]);
+			fprintf(sgpProfileFile, "\n");
+			sgbProfileHeader = TRUE;
+		}
+	}
+
+	fprintf(sgpProfileFile, "%u,%d,%u", sgdwProfileFrameNum, currlevel, frameTime);
+	for (i = 0; i < NUM_PROFILE_ZONES; i++)
+		fprintf(sgpProfileFile, ",%u", sgdwProfileFrame[i]);
+	fprintf(sgpProfileFile, "\n");
+}
+
+/**
+ * @brief Close the frame, called once per DrawAndBlit
+ */
+void profile_frame()
+{
+	int i;
+	DWORD frameTime, tc;
+	unsigned long long now;
+
+	if (sgnProfileMode == 0)
+		return;
+
+	now = profile_now();
+	frameTime = sgProfileFrameStart != 0 ? (DWORD)(now - sgProfileFrameStart) : 0;
+	sgProfileFrameStart = now;
+	sgdwProfileFrameNum++;
+
+	if (frameTime != 0)
+		profile_add_sample(NUM_PROFILE_ZONES, frameTime);
+	for (i = 0; i < NUM_PROFILE_ZONES; i++) {
+		if (sgbProfileHit[i])
+			profile_add_sample(i, sgdwProfileFrame[i]);
+	}
+	if (sgnProfileMode == 2)
+		profile_write(frameTime);
+	memset(sgdwProfileFrame, 0, sizeof(sgdwProfileFrame));
+	memset(sgbProfileHit, 0, sizeof(sgbProfileHit));
+
+	tc = GetTickCount();
+	if (tc - sgdwProfileUpdated >= 1000) {
+		sgdwProfileUpdated = tc;
+		profile_percentiles();
+	}
+}
+
+static void profile_draw_line(int y, const char *name, int i)
+{
+	char String[64];
+
+	snprintf(String, sizeof(String), "%s %u.%02u %u.%02u %u.%02u", name,
+	    sgdwProfileP50[i] / 1000, sgdwProfileP50[i] % 1000 / 10,
+	    sgdwProfileP95[i] / 1000, sgdwProfileP95[i] % 1000 / 10,
+	    sgdwProfileP99[i] / 1000, sgdwProfileP99[i] % 1000 / 10);
+	PrintGameStr(8, y, String, COL_WHITE);
+}
+
+/**
+ * @brief Show the 50th, 95th and 99th percentile in milliseconds of the last frames for each zone
+ */
+void profile_draw()
+{
+	int i, y;
+
+	if (sgnProfileMode == 0 || !gbActive || !pPanelText)
+		return;
+
+	y = 125;
+	PrintGameStr(8, y, "ms p50 p95 p99", COL_GOLD);
+	y += 15;
+	profile_draw_line(y, "Frame", NUM_PROFILE_ZONES);
+	for (i = 0; i < NUM_PROFILE_ZONES; i++) {
+		if (sgnProfileSamples[i] == 0)
+			continue;
+		y += 15;
+		profile_draw_line(y, ProfileZoneNames[i], i);
+	}
+}
+
+/**
+ * @brief Flush the CSV dump at the end of a game
+ */
+void profile_free()
+{
+	if (sgpProfileFile != NULL) {
+		fclose(sgpProfileFile);
+		sgpProfileFile = NULL;
+	}
+	sgProfileFrameStart = 0;
+}
+
+DEVILUTION_END_NAMESPACE
@@ -0,0 +1,11 @@
+//HEADER_GOES_HERE
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+void profile_begin(int zone);
+void profile_end(int zone);
+void profile_frame();
+void profile_draw();
+void profile_free();
+
+#endif /* __PROFILE_H__ */
@@ -1,4 +1,27 @@
 #include "diablo.h"
+#include "../3rdParty/Storm/Source/storm.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define RENDER_X86
+#define RENDER_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define RENDER_X86
+#define RENDER_TARGET(isa)
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define RENDER_NEON
+#endif
+
+#ifdef RENDER_X86
+#include <emmintrin.h>
+// SDL 1.2 has no AVX2 detection
+#if !defined(USE_SDL1)
+#define RENDER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+#ifdef RENDER_NEON
+#include <arm_neon.h>
+#endif
 
 DEVILUTION_BEGIN_NAMESPACE
 
@@ -89,12 +112,188 @@ static DWORD SolidMask[32] = {
 	0xFFFFFFFF, 0xFFFFFFFF
 };
 
-inline static void RenderLine(BYTE **dst, BYTE **src, int n, BYTE *tbl, DWORD mask)
+/**
+ * Byte expansions of the bit masks above, one byte (0x00 or 0xFF) per pixel,
+ * so that masked rows can be blended instead of tested bit by bit.
+ */
+static BYTE RightMaskBytes[32][32];
+static BYTE LeftMaskBytes[32][32];
+static BYTE WallMaskBytes[32][32];
+static BYTE SolidMaskBytes[32][32];
+
+static const BYTE ZeroRow[32] = { 0 };
+
+/** Blends src into dst where the byte mask is 0xFF */
+typedef void (*BlendLineFn)(BYTE *dst, const BYTE *src, int n, const BYTE *bmask);
+/** Maps n pixels from src to dst through a 256 entry light table */
+typedef void (*LightLineFn)(BYTE *dst, const BYTE *src, int n, const BYTE *tbl);
+
+static BlendLineFn RenderBlend;
+static LightLineFn RenderLight;
+
+static void BlendLineScalar(BYTE *dst, const BYTE *src, int n, const BYTE *bmask)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		dst[i] = (src[i] & bmask[i]) | (dst[i] & ~bmask[i]);
+	}
+}
+
+static void LightLineScalar(BYTE *dst, const BYTE *src, int n, const BYTE *tbl)
+{
+	int i;
+
+	for (; n >= 4; n -= 4, dst += 4, src += 4) {
+		dst[0] = tbl[src[0]];
+		dst[1] = tbl[src[1]];
+		dst[2] = tbl[src[2]];
+		dst[3] = tbl[src[3]];
+	}
+	for (i = 0; i < n; i++) {
+		dst[i] = tbl[src[i]];
+	}
+}
+
+#ifdef RENDER_X86
+RENDER_TARGET("sse2")
+static void BlendLineSSE2(BYTE *dst, const BYTE *src, int n, const BYTE *bmask)
+{
+	__m128i m, s, d;
+
+	for (; n >= 16; n -= 16, dst += 16, src += 16, bmask += 16) {
+		m = _mm_loadu_si128((const __m128i *)bmask);
+		s = _mm_loadu_si128((const __m128i *)src);
+		d = _mm_loadu_si128((const __m128i *)dst);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_and_si128(m, s), _mm_andnot_si128(m, d)));
+	}
+	BlendLineScalar(dst, src, n, bmask);
+}
+
+#ifdef RENDER_AVX2
+RENDER_TARGET("avx2")
+static void BlendLineAVX2(BYTE *dst, const BYTE *src, int n, const BYTE *bmask)
 {
+	__m256i m, s, d;
+
+	if (n == 32) {
+		m = _mm256_loadu_si256((const __m256i *)bmask);
+		s = _mm256_loadu_si256((const __m256i *)src);
+		d = _mm256_loadu_si256((const __m256i *)dst);
+		_mm256_storeu_si256((__m256i *)dst, _mm256_blendv_epi8(d, s, m));
+		return;
+	}
+	BlendLineSSE2(dst, src, n, bmask);
+}
+#endif
+#endif
+
+#ifdef RENDER_NEON
+static void BlendLineNEON(BYTE *dst, const BYTE *src, int n, const BYTE *bmask)
+{
+	for (; n >= 16; n -= 16, dst += 16, src += 16, bmask += 16) {
+		vst1q_u8(dst, vbslq_u8(vld1q_u8(bmask), vld1q_u8(src), vld1q_u8(dst)));
+	}
+	BlendLineScalar(dst, src, n, bmask);
+}
+
+#ifdef __aarch64__
+/**
+ * Gathers 16 pixels at a time by splitting the light table into four 64 byte
+ * tables; TBX leaves lanes with out of range indices untouched.
+ */
+static void LightLineNEON(BYTE *dst, const BYTE *src, int n, const BYTE *tbl)
+{
+	uint8x16x4_t t0, t1, t2, t3;
+	uint8x16_t idx, px;
+	const uint8x16_t step = vdupq_n_u8(64);
 	int i;
 
+	if (n < 16) {
+		LightLineScalar(dst, src, n, tbl);
+		return;
+	}
+
+	for (i = 0; i < 4; i++) {
+		t0.val[i] = vld1q_u8(&tbl[i * 16]);
+		t1.val[i] = vld1q_u8(&tbl[64 + i * 16]);
+		t2.val[i] = vld1q_u8(&tbl[128 + i * 16]);
+		t3.val[i] = vld1q_u8(&tbl[192 + i * 16]);
+	}
+
+	for (; n >= 16; n -= 16, dst += 16, src += 16) {
+		idx = vld1q_u8(src);
+		px = vqtbl4q_u8(t0, idx);
+		idx = vsubq_u8(idx, step);
+		px = vqtbx4q_u8(px, t1, idx);
+		idx = vsubq_u8(idx, step);
+		px = vqtbx4q_u8(px, t2, idx);
+		idx = vsubq_u8(idx, step);
+		px = vqtbx4q_u8(px, t3, idx);
+		vst1q_u8(dst, px);
+	}
+	LightLineScalar(dst, src, n, tbl);
+}
+#endif
+#endif
+
+static void ExpandMask(BYTE (*dst)[32], const DWORD *mask)
+{
+	int i, j;
+
+	for (i = 0; i < 32; i++) {
+		for (j = 0; j < 32; j++) {
+			dst[i][j] = (mask[i] << j) & 0x80000000 ? 0xFF : 0;
+		}
+	}
+}
+
+/**
+ * @brief Expand the tile masks and pick the fastest row kernels the CPU supports
+ */
+static void InitRenderKernels()
+{
+	ExpandMask(RightMaskBytes, RightMask);
+	ExpandMask(LeftMaskBytes, LeftMask);
+	ExpandMask(WallMaskBytes, WallMask);
+	ExpandMask(SolidMaskBytes, SolidMask);
+
+	RenderBlend = BlendLineScalar;
+	RenderLight = LightLineScalar;
+#ifdef RENDER_X86
+	if (SDL_HasSSE2())
+		RenderBlend = BlendLineSSE2;
+#ifdef RENDER_AVX2
+	if (SDL_HasAVX2())
+		RenderBlend = BlendLineAVX2;
+#endif
+#endif
+#ifdef RENDER_NEON
+	RenderBlend = BlendLineNEON;
+#ifdef __aarch64__
+	RenderLight = LightLineNEON;
+#endif
+#endif
+}
+
+/**
+ * Everything a tile decode reads besides the CEL data itself, so the same
+ * code can draw to the back buffer or into a tile cache entry.
+ */
+typedef struct TileContext {
+	BYTE *tbl;
+	int light;
+	int pitch;
+	BYTE *clipStart;
+	BYTE *clipEnd;
+} TileContext;
+
+inline static void RenderLine(BYTE **dst, BYTE **src, int n, const TileContext *ctx, DWORD mask, const BYTE *bmask)
+{
+	BYTE lit[32];
+
 #ifdef NO_OVERDRAW
-	if (*dst < gpBufStart || *dst > gpBufEnd) {
+	if (*dst < ctx->clipStart || *dst > ctx->clipEnd) {
 		*src += n;
 		*dst += n;
 		return;
@@ -102,100 +301,51 @@ inline static void RenderLine(BYTE **dst, BYTE **src, int n, BYTE *tbl, DWORD ma
 #endif
 
 	if (mask == 0xFFFFFFFF) {
-		if (light_table_index == lightmax) {
+		if (ctx->light == lightmax) {
 			memset(*dst, 0, n);
-			(*src) += n;
-			(*dst) += n;
-		} else if (light_table_index == 0) {
+		} else if (ctx->light == 0) {
 			memcpy(*dst, *src, n);
-			(*src) += n;
-			(*dst) += n;
 		} else {
-			for (i = 0; i < n; i++, (*src)++, (*dst)++) {
-				(*dst)[0] = tbl[(*src)[0]];
-			}
+			RenderLight(*dst, *src, n, ctx->tbl);
 		}
 	} else {
-		if (light_table_index == lightmax) {
-			(*src) += n;
-			for (i = 0; i < n; i++, (*dst)++, mask <<= 1) {
-				if (mask & 0x80000000) {
-					(*dst)[0] = 0;
-				}
-			}
-		} else if (light_table_index == 0) {
-			for (i = 0; i < n; i++, (*src)++, (*dst)++, mask <<= 1) {
-				if (mask & 0x80000000) {
-					(*dst)[0] = (*src)[0];
-				}
-			}
+		if (ctx->light == lightmax) {
+			RenderBlend(*dst, ZeroRow, n, bmask);
+		} else if (ctx->light == 0) {
+			RenderBlend(*dst, *src, n, bmask);
 		} else {
-			for (i = 0; i < n; i++, (*src)++, (*dst)++, mask <<= 1) {
-				if (mask & 0x80000000) {
-					(*dst)[0] = tbl[(*src)[0]];
-				}
-			}
+			RenderLight(lit, *src, n, ctx->tbl);
+			RenderBlend(*dst, lit, n, bmask);
 		}
 	}
+	(*src) += n;
+	(*dst) += n;
 }
 
 #if defined(__clang__) || defined(__GNUC__)
 __attribute__((no_sanitize("shift-base")))
 #endif
-void
-RenderTile(BYTE *pBuff)
+static void
+RenderTileShape(BYTE *dst, BYTE *src, char tile, const TileContext *ctx, DWORD *mask, BYTE (*bmask)[32])
 {
 	int i, j;
-	char c, v, tile;
-	BYTE *src, *dst, *tbl;
-	DWORD m, *mask, *pFrameTable;
-
-	dst = pBuff;
-	pFrameTable = (DWORD *)pDungeonCels;
-
-	src = &pDungeonCels[SDL_SwapLE32(pFrameTable[level_cel_block & 0xFFF])];
-	tile = (level_cel_block & 0x7000) >> 12;
-	tbl = &pLightTbl[256 * light_table_index];
-
-	mask = &SolidMask[31];
-
-	if (cel_transparency_active) {
-		if (arch_draw_type == 0) {
-			mask = &WallMask[31];
-		}
-		if (arch_draw_type == 1 && tile != RT_LTRIANGLE) {
-			c = block_lvid[level_piece_id];
-			if (c == 1 || c == 3) {
-				mask = &LeftMask[31];
-			}
-		}
-		if (arch_draw_type == 2 && tile != RT_RTRIANGLE) {
-			c = block_lvid[level_piece_id];
-			if (c == 2 || c == 3) {
-				mask = &RightMask[31];
-			}
-		}
-	}
-
-#ifdef _DEBUG
-	if (GetAsyncKeyState(VK_MENU) & 0x8000) {
-		mask = &SolidMask[31];
-	}
-#endif
+	char v;
+	DWORD m;
+	const int skip = ctx->pitch + 32;
 
 	switch (tile) {
 	case RT_SQUARE:
-		for (i = 32; i != 0; i--, dst -= BUFFER_WIDTH + 32, mask--) {
-			RenderLine(&dst, &src, 32, tbl, *mask);
+		for (i = 32; i != 0; i--, dst -= skip, mask--, bmask--) {
+			RenderLine(&dst, &src, 32, ctx, *mask, *bmask);
 		}
 		break;
 	case RT_TRANSPARENT:
-		for (i = 32; i != 0; i--, dst -= BUFFER_WIDTH + 32, mask--) {
+		for (i = 32; i != 0; i--, dst -= skip, mask--, bmask--) {
 			m = *mask;
 			for (j = 32; j != 0; j -= v, m <<= v) {
 				v = *src++;
 				if (v >= 0) {
-					RenderLine(&dst, &src, v, tbl, m);
+					RenderLine(&dst, &src, v, ctx, m, &(*bmask)[32 - j]);
 				} else {
 					v = -v;
 					dst += v;
@@ -204,52 +354,359 @@ RenderTile(BYTE *pBuff)
 		}
 		break;
 	case RT_LTRIANGLE:
-		for (i = 30; i >= 0; i -= 2, dst -= BUFFER_WIDTH + 32, mask--) {
+		for (i = 30; i >= 0; i -= 2, dst -= skip, mask--, bmask--) {
 			src += i & 2;
 			dst += i;
-			RenderLine(&dst, &src, 32 - i, tbl, *mask);
+			RenderLine(&dst, &src, 32 - i, ctx, *mask, *bmask);
 		}
-		for (i = 2; i != 32; i += 2, dst -= BUFFER_WIDTH + 32, mask--) {
+		for (i = 2; i != 32; i += 2, dst -= skip, mask--, bmask--) {
 			src += i & 2;
 			dst += i;
-			RenderLine(&dst, &src, 32 - i, tbl, *mask);
+			RenderLine(&dst, &src, 32 - i, ctx, *mask, *bmask);
 		}
 		break;
 	case RT_RTRIANGLE:
-		for (i = 30; i >= 0; i -= 2, dst -= BUFFER_WIDTH + 32, mask--) {
-			RenderLine(&dst, &src, 32 - i, tbl, *mask);
+		for (i = 30; i >= 0; i -= 2, dst -= skip, mask--, bmask--) {
+			RenderLine(&dst, &src, 32 - i, ctx, *mask, *bmask);
 			src += i & 2;
 			dst += i;
 		}
-		for (i = 2; i != 32; i += 2, dst -= BUFFER_WIDTH + 32, mask--) {
-			RenderLine(&dst, &src, 32 - i, tbl, *mask);
+		for (i = 2; i != 32; i += 2, dst -= skip, mask--, bmask--) {
+			RenderLine(&dst, &src, 32 - i, ctx, *mask, *bmask);
 			src += i & 2;
 			dst += i;
 		}
 		break;
 	case RT_LTRAPEZOID:
-		for (i = 30; i >= 0; i -= 2, dst -= BUFFER_WIDTH + 32, mask--) {
+		for (i = 30; i >= 0; i -= 2, dst -= skip, mask--, bmask--) {
 			src += i & 2;
 			dst += i;
-			RenderLine(&dst, &src, 32 - i, tbl, *mask);
+			RenderLine(&dst, &src, 32 - i, ctx, *mask, *bmask);
 		}
-		for (i = 16; i != 0; i--, dst -= BUFFER_WIDTH + 32, mask--) {
-			RenderLine(&dst, &src, 32, tbl, *mask);
+		for (i = 16; i != 0; i--, dst -= skip, mask--, bmask--) {
+			RenderLine(&dst, &src, 32, ctx, *mask, *bmask);
 		}
 		break;
 	case RT_RTRAPEZOID:
-		for (i = 30; i >= 0; i -= 2, dst -= BUFFER_WIDTH + 32, mask--) {
-			RenderLine(&dst, &src, 32 - i, tbl, *mask);
+		for (i = 30; i >= 0; i -= 2, dst -= skip, mask--, bmask--) {
+			RenderLine(&dst, &src, 32 - i, ctx, *mask, *bmask);
 			src += i & 2;
 			dst += i;
 		}
-		for (i = 16; i != 0; i--, dst -= BUFFER_WIDTH + 32, mask--) {
-			RenderLine(&dst, &src, 32, tbl, *mask);
+		for (i = 16; i != 0; i--, dst -= skip, mask--, bmask--) {
+			RenderLine(&dst, &src, 32, ctx, *mask, *bmask);
 		}
 		break;
 	}
 }
 
+/**
+ * One decoded and lit micro tile. Rows are stored top to bottom, alpha is
+ * 0xFF for every pixel the tile would write with its transparency mask.
+ */
+typedef struct TileCacheEntry {
+	DWORD key;
+	int hnext;
+	int prev;
+	int next;
+	BYTE pixels[32][32];
+	BYTE alpha[32][32];
+} TileCacheEntry;
+
+/**
+ * LRU cache of decoded tiles, every render thread owns one so lookups need no locking.
+ */
+typedef struct TileCache {
+	TileCacheEntry *entries;
+	int *buckets;
+	int size;
+	int used;
+	int mru;
+	int lru;
+	DWORD bucket_mask;
+	DWORD hits;
+	DWORD misses;
+} TileCache;
+
+/** Bumped every time the cached tiles are dropped, i.e. the tile output changes */
+DWORD tile_cache_generation;
+
+static TileCache tile_caches[MAX_RENDER_THREADS];
+static int tile_cache_count;
+/** Cache of the render thread running on this thread */
+static thread_local TileCache *tile_cache = &tile_caches[0];
+/** Light table that turns every decoded pixel into 0xFF, used to build the alpha plane */
+static BYTE AlphaTbl[256];
+
+static DWORD TileCacheHash(const TileCache *c, DWORD key)
+{
+	return (key * 0x9E3779B1) >> 8 & c->bucket_mask;
+}
+
+static void TileCacheUnlink(TileCache *c, int i)
+{
+	TileCacheEntry *e = &c->entries[i];
+
+	if (e->prev != -1)
+		c->entries[e->prev].next = e->next;
+	else
+		c->mru = e->next;
+	if (e->next != -1)
+		c->entries[e->next].prev = e->prev;
+	else
+		c->lru = e->prev;
+}
+
+static void TileCachePushFront(TileCache *c, int i)
+{
+	TileCacheEntry *e = &c->entries[i];
+
+	e->prev = -1;
+	e->next = c->mru;
+	if (c->mru != -1)
+		c->entries[c->mru].prev = i;
+	c->mru = i;
+	if (c->lru == -1)
+		c->lru = i;
+}
+
+/**
+ * @brief Allocate the tile caches, the size in KB is read from the "Tile Cache Size" setting (0 disables them)
+ * @param threads Number of render threads, the size is split evenly between them
+ */
+static void InitTileCache(int threads)
+{
+	int i, kb, size, buckets;
+	TileCache *c;
+
+	kb = 1024;
+	if (!SRegLoadValue("devilutionx", "Tile Cache Size", 0, &kb))
+		SRegSaveValue("devilutionx", "Tile Cache Size", 0, kb);
+	if (kb <= 0)
+		return;
+
+	size = kb * 1024 / threads / (sizeof(TileCacheEntry) + 2 * sizeof(int));
+	if (size == 0)
+		return;
+	for (buckets = 1; buckets < size; buckets <<= 1)
+		;
+	for (i = 0; i < threads; i++) {
+		c = &tile_caches[i];
+		c->size = size;
+		c->bucket_mask = buckets - 1;
+		c->entries = (TileCacheEntry *)DiabloAllocPtr(size * sizeof(TileCacheEntry));
+		c->buckets = (int *)DiabloAllocPtr(buckets * sizeof(int));
+	}
+	tile_cache_count = threads;
+	for (i = 0; i < 256; i++)
+		AlphaTbl[i] = 0xFF;
+	ClearTileCache();
+}
+
+/**
+ * @brief Pick the row kernels and set up a tile cache for every render thread
+ * @param threads Number of threads that will call RenderTile, must be called before any of them does
+ */
+void InitRender(int threads)
+{
+	if (RenderBlend != NULL)
+		return;
+
+	InitRenderKernels();
+	InitTileCache(threads);
+}
+
+/**
+ * @brief Make the calling thread use the tile cache of render thread id
+ */
+void SetRenderThread(int id)
+{
+	tile_cache = &tile_caches[id];
+}
+
+/**
+ * @brief Drop all cached tiles, needed whenever pDungeonCels or pLightTbl change
+ */
+void ClearTileCache()
+{
+	int i;
+	TileCache *c;
+
+	tile_cache_generation++;
+	for (i = 0; i < tile_cache_count; i++) {
+		c = &tile_caches[i];
+		memset(c->buckets, -1, (c->bucket_mask + 1) * sizeof(int));
+		c->used = 0;
+		c->mru = -1;
+		c->lru = -1;
+	}
+}
+
+/**
+ * @brief Sum the tile cache lookups of all render threads
+ */
+void GetTileCacheStats(DWORD *hits, DWORD *misses)
+{
+	int i;
+
+	*hits = 0;
+	*misses = 0;
+	for (i = 0; i < tile_cache_count; i++) {
+		*hits += tile_caches[i].hits;
+		*misses += tile_caches[i].misses;
+	}
+}
+
+static TileCacheEntry *TileCacheLookup(TileCache *c, DWORD key, BYTE *src, char tile, DWORD *mask, BYTE (*bmask)[32])
+{
+	int i, *link;
+	DWORD h;
+	TileCacheEntry *e;
+	TileContext ctx;
+
+	h = TileCacheHash(c, key);
+	for (i = c->buckets[h]; i != -1; i = c->entries[i].hnext) {
+		if (c->entries[i].key == key) {
+			c->hits++;
+			if (c->mru != i) {
+				TileCacheUnlink(c, i);
+				TileCachePushFront(c, i);
+			}
+			return &c->entries[i];
+		}
+	}
+
+	c->misses++;
+	if (c->used < c->size) {
+		i = c->used++;
+	} else {
+		i = c->lru;
+		TileCacheUnlink(c, i);
+		for (link = &c->buckets[TileCacheHash(c, c->entries[i].key)]; *link != i; link = &c->entries[*link].hnext)
+			;
+		*link = c->entries[i].hnext;
+	}
+
+	e = &c->entries[i];
+	e->key = key;
+	e->hnext = c->buckets[h];
+	c->buckets[h] = i;
+	TileCachePushFront(c, i);
+
+	memset(e->pixels, 0, sizeof(e->pixels));
+	memset(e->alpha, 0, sizeof(e->alpha));
+	ctx.light = light_table_index;
+	ctx.tbl = &pLightTbl[256 * light_table_index];
+	ctx.pitch = 32;
+	ctx.clipStart = &e->pixels[0][0];
+	ctx.clipEnd = &e->pixels[31][31];
+	RenderTileShape(e->pixels[31], src, tile, &ctx, mask, bmask);
+	ctx.light = -1;
+	ctx.tbl = AlphaTbl;
+	ctx.clipStart = &e->alpha[0][0];
+	ctx.clipEnd = &e->alpha[31][31];
+	RenderTileShape(e->alpha[31], src, tile, &ctx, mask, bmask);
+
+	return e;
+}
+
+/**
+ * @brief Copy a cached tile to the back buffer, honoring the same per row clipping as RenderLine
+ * @return FALSE if a row straddles the clip window and the tile must be decoded normally
+ */
+static BOOL TileCacheBlit(BYTE *pBuff, const TileCacheEntry *e)
+{
+	int i;
+	BYTE *dst;
+
+#ifdef NO_OVERDRAW
+	for (i = 0, dst = pBuff; i < 32; i++, dst -= BUFFER_WIDTH) {
+		if (dst + 31 < gpBufStart || dst > gpBufEnd)
+			continue;
+		if (dst < gpBufStart || dst + 31 > gpBufEnd)
+			return FALSE;
+	}
+#endif
+
+	for (i = 31, dst = pBuff; i >= 0; i--, dst -= BUFFER_WIDTH) {
+#ifdef NO_OVERDRAW
+		if (dst < gpBufStart || dst > gpBufEnd)
+			continue;
+#endif
+		RenderBlend(dst, e->pixels[i], 32, e->alpha[i]);
+	}
+
+	return TRUE;
+}
+
+void RenderTile(BYTE *pBuff)
+{
+	char c, tile;
+	int maskType;
+	BYTE *src;
+	DWORD *mask, *pFrameTable;
+	BYTE(*bmask)[32];
+	TileCacheEntry *e;
+	TileContext ctx;
+
+	if (RenderBlend == NULL)
+		InitRender(1);
+
+	pFrameTable = (DWORD *)pDungeonCels;
+
+	src = &pDungeonCels[SDL_SwapLE32(pFrameTable[level_cel_block & 0xFFF])];
+	tile = (level_cel_block & 0x7000) >> 12;
+
+	mask = &SolidMask[31];
+	bmask = &SolidMaskBytes[31];
+	maskType = 0;
+
+	if (cel_transparency_active) {
+		if (arch_draw_type == 0) {
+			mask = &WallMask[31];
+			bmask = &WallMaskBytes[31];
+			maskType = 1;
+		}
+		if (arch_draw_type == 1 && tile != RT_LTRIANGLE) {
+			c = block_lvid[level_piece_id];
+			if (c == 1 || c == 3) {
+				mask = &LeftMask[31];
+				bmask = &LeftMaskBytes[31];
+				maskType = 2;
+			}
+		}
+		if (arch_draw_type == 2 && tile != RT_RTRIANGLE) {
+			c = block_lvid[level_piece_id];
+			if (c == 2 || c == 3) {
+				mask = &RightMask[31];
+				bmask = &RightMaskBytes[31];
+				maskType = 3;
+			}
+		}
+	}
+
+#ifdef _DEBUG
+	if (GetAsyncKeyState(VK_MENU) & 0x8000) {
+		mask = &SolidMask[31];
+		bmask = &SolidMaskBytes[31];
+		maskType = 0;
+	}
+#endif
+
+	if (tile_cache->entries != NULL) {
+		e = TileCacheLookup(tile_cache, (level_cel_block & 0xFFFF) << 10 | (light_table_index & 0xFF) << 2 | maskType, src, tile, mask, bmask);
+		if (TileCacheBlit(pBuff, e))
+			return;
+	}
+
+	ctx.light = light_table_index;
+	ctx.tbl = &pLightTbl[256 * light_table_index];
+	ctx.pitch = BUFFER_WIDTH;
+	ctx.clipStart = gpBufStart;
+	ctx.clipEnd = gpBufEnd;
+	RenderTileShape(pBuff, src, tile, &ctx, mask, bmask);
+}
+
 /**
  * @brief Render a black tile
  * @param pBuff pointer where to render the tile
@@ -264,11 +721,16 @@ void world_draw_black_tile(int sx, int sy)
 
 	dst = &gpBuffer[sx + BUFFER_WIDTH * sy] + 30;
 
+	// same row test as RenderLine, so both bands at an edge agree on who draws a row
 	for (i = 30, j = 1; i >= 0; i -= 2, j++, dst -= BUFFER_WIDTH + 2) {
+		if (dst < gpBufStart || dst > gpBufEnd)
+			continue;
 		memset(dst, 0, 4 * j);
 	}
 	dst += 4;
 	for (i = 2, j = 15; i != 32; i += 2, j--, dst -= BUFFER_WIDTH - 2) {
+		if (dst < gpBufStart || dst > gpBufEnd)
+			continue;
 		memset(dst, 0, 4 * j);
 	}
 }
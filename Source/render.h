@@ -1,6 +1,12 @@
 #ifndef __RENDER_H__
 #define __RENDER_H__
 
+extern DWORD tile_cache_generation;
+
+void InitRender(int threads);
+void SetRenderThread(int id);
+void ClearTileCache();
+void GetTileCacheStats(DWORD *hits, DWORD *misses);
 void RenderTile(BYTE *pBuff);
 #define drawUpperScreen(p) RenderTile(p)
 #define drawLowerScreen(p) RenderTile(p)
@@ -1,20 +1,21 @@
 #include "diablo.h"
+#include "../3rdParty/Storm/Source/storm.h"
 
 DEVILUTION_BEGIN_NAMESPACE
 
-int light_table_index;
+thread_local int light_table_index;
 DWORD sgdwCursWdtOld;
 DWORD sgdwCursX;
 DWORD sgdwCursY;
-BYTE *gpBufStart;
-BYTE *gpBufEnd;
+thread_local BYTE *gpBufStart;
+thread_local BYTE *gpBufEnd;
 DWORD sgdwCursHgt;
-DWORD level_cel_block;
+thread_local DWORD level_cel_block;
 DWORD sgdwCursXOld;
 DWORD sgdwCursYOld;
-char arch_draw_type;
-int cel_transparency_active;
-int level_piece_id;
+thread_local char arch_draw_type;
+thread_local int cel_transparency_active;
+thread_local int level_piece_id;
 DWORD sgdwCursWdt;
 void (*DrawPlrProc)(int, int, int, int, int, BYTE *, int, int, int, int);
 BYTE sgSaveBack[8192];
@@ -377,9 +378,9 @@ void DrawDeadPlayer(int x, int y, int sx, int sy)
 	int i, px, py, nCel, frames;
 	PlayerStruct *p;
 	BYTE *pCelBuff;
+	BOOL found;
 
-	dFlags[x][y] &= ~BFLAG_DEAD_PLAYER;
-
+	found = FALSE;
 	for (i = 0; i < MAX_PLRS; i++) {
 		p = &plr[i];
 		if (p->plractive && !p->_pHitPoints && p->plrlevel == (BYTE)currlevel && p->WorldX == x && p->WorldY == y) {
@@ -394,12 +395,16 @@ void DrawDeadPlayer(int x, int y, int sx, int sy)
 				// app_fatal("Drawing dead player %d \"%s\": facing %d, frame %d of %d", i, p->_pName, p->_pdir, nCel, frame);
 				break;
 			}
-			dFlags[x][y] |= BFLAG_DEAD_PLAYER;
+			found = TRUE;
 			px = sx + p->_pxoff - p->_pAnimWidth2;
 			py = sy + p->_pyoff;
 			DrawPlayer(i, x, y, px, py, p->_pAnimData, p->_pAnimFrame, p->_pAnimWidth);
 		}
 	}
+
+	// Only ever clear the flag, render threads sharing the cell must not see it flicker
+	if (!found)
+		dFlags[x][y] &= ~BFLAG_DEAD_PLAYER;
 }
 
 /**
@@ -712,6 +717,560 @@ static void scrollrt_draw(int x, int y, int sx, int sy, int chunks, int row)
 	}
 }
 
+/** Height of the horizontal viewport bands tracked by the incremental redraw */
+#define VIEWPORT_BAND_HEIGHT 32
+#define VIEWPORT_BANDS ((VIEWPORT_HEIGHT + VIEWPORT_BAND_HEIGHT - 1) / VIEWPORT_BAND_HEIGHT)
+/** Rows above a cell's base line that its tiles, sprites and e-flag redraws can touch */
+#define CELL_REACH_UP 320
+/** Rows below a cell's base line that its sprites and outlines can touch */
+#define CELL_REACH_DOWN 64
+
+/** Only redraw and blit the parts of the viewport that changed */
+static BOOL sgbIncrementalRedraw;
+static BOOL sgbIncrementalInit;
+/** Viewport as left by DrawGame, before panels and cursor are drawn on top */
+static BYTE *sgpGameLayer;
+static BOOL sgbGameLayerValid;
+static unsigned long long sgBandHash[VIEWPORT_BANDS];
+/** Viewport as last handed to BltFast */
+static BYTE *sgpBlitCopy;
+static BOOL sgbBlitCopyValid;
+static unsigned int sgdwBlitPalVersion;
+
+static void InitIncrementalRedraw()
+{
+	int enabled;
+
+	sgbIncrementalInit = TRUE;
+	enabled = 0;
+	if (!SRegLoadValue("devilutionx", "Incremental Redraw", 0, &enabled))
+		SRegSaveValue("devilutionx", "Incremental Redraw", 0, enabled);
+	if (!enabled)
+		return;
+
+	sgpGameLayer = DiabloAllocPtr(VIEWPORT_HEIGHT * BUFFER_WIDTH);
+	sgpBlitCopy = DiabloAllocPtr(VIEWPORT_HEIGHT * SCREEN_WIDTH);
+	sgbIncrementalRedraw = TRUE;
+}
+
+static unsigned long long RenderHash(unsigned long long h, DWORD v)
+{
+	return (h ^ v) * 1099511628211ULL;
+}
+
+static unsigned long long HashMonster(unsigned long long h, int mi)
+{
+	MonsterStruct *pMonster;
+
+	h = RenderHash(h, mi == pcursmonst);
+	if (leveltype == DTYPE_TOWN) {
+		h = RenderHash(h, (DWORD)(size_t)towner[mi]._tAnimData);
+		h = RenderHash(h, towner[mi]._tAnimFrame);
+		h = RenderHash(h, towner[mi]._tAnimWidth);
+		return RenderHash(h, towner[mi]._tAnimWidth2);
+	}
+	if ((DWORD)mi >= MAXMONSTERS)
+		return h;
+
+	pMonster = &monster[mi];
+	h = RenderHash(h, (DWORD)(size_t)pMonster->_mAnimData);
+	h = RenderHash(h, pMonster->_mAnimFrame);
+	h = RenderHash(h, (DWORD)(size_t)pMonster->MType);
+	h = RenderHash(h, pMonster->_mxoff);
+	h = RenderHash(h, pMonster->_myoff);
+	h = RenderHash(h, pMonster->_mFlags);
+	h = RenderHash(h, pMonster->_mmode == MM_STONE);
+	h = RenderHash(h, pMonster->_uniqtype);
+	h = RenderHash(h, pMonster->_uniqtrans);
+	return RenderHash(h, pMonster->_meflag);
+}
+
+static unsigned long long HashPlayer(unsigned long long h, int pnum)
+{
+	PlayerStruct *pPlayer;
+
+	if ((DWORD)pnum >= MAX_PLRS)
+		return h;
+
+	pPlayer = &plr[pnum];
+	h = RenderHash(h, pnum == pcursplr);
+	h = RenderHash(h, (DWORD)(size_t)pPlayer->_pAnimData);
+	h = RenderHash(h, pPlayer->_pAnimFrame);
+	h = RenderHash(h, pPlayer->_pAnimWidth);
+	h = RenderHash(h, pPlayer->_pAnimWidth2);
+	h = RenderHash(h, pPlayer->_pxoff);
+	h = RenderHash(h, pPlayer->_pyoff);
+	h = RenderHash(h, pPlayer->pManaShield);
+	return RenderHash(h, pPlayer->_peflag);
+}
+
+static unsigned long long HashMissile(unsigned long long h, MissileStruct *m)
+{
+	h = RenderHash(h, m->_miPreFlag);
+	h = RenderHash(h, m->_miDrawFlag);
+	h = RenderHash(h, (DWORD)(size_t)m->_miAnimData);
+	h = RenderHash(h, m->_miAnimFrame);
+	h = RenderHash(h, m->_miAnimWidth);
+	h = RenderHash(h, m->_miAnimWidth2);
+	h = RenderHash(h, m->_mixoff);
+	h = RenderHash(h, m->_miyoff);
+	h = RenderHash(h, m->_miUniqTrans);
+	return RenderHash(h, m->_miLightFlag);
+}
+
+/**
+ * @brief Hash everything scrollrt_draw_dungeon and drawRow read for one cell
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ */
+static unsigned long long HashCell(int x, int y)
+{
+	int i, bv;
+	char bFlag;
+	unsigned long long h;
+	ObjectStruct *pObject;
+	ItemStruct *pItem;
+	PlayerStruct *pPlayer;
+
+	h = 14695981039346656037ULL;
+	if (x < 0 || x >= MAXDUNX || y < 0 || y >= MAXDUNY)
+		return h;
+
+	bFlag = dFlags[x][y];
+	h = RenderHash(h, dPiece[x][y]);
+	h = RenderHash(h, (BYTE)dLight[x][y]);
+	h = RenderHash(h, (BYTE)bFlag);
+	h = RenderHash(h, TransList[dTransVal[x][y]]);
+	h = RenderHash(h, (BYTE)dDead[x][y]);
+	h = RenderHash(h, (BYTE)dArch[x][y]);
+
+	bv = dObject[x][y];
+	h = RenderHash(h, bv);
+	if (bv != 0) {
+		bv = bv > 0 ? bv - 1 : -(bv + 1);
+		pObject = &object[bv];
+		h = RenderHash(h, bv == pcursobj);
+		h = RenderHash(h, (DWORD)(size_t)pObject->_oAnimData);
+		h = RenderHash(h, pObject->_oAnimFrame);
+		h = RenderHash(h, pObject->_oAnimWidth);
+		h = RenderHash(h, pObject->_oAnimWidth2);
+		h = RenderHash(h, pObject->_oPreFlag);
+		h = RenderHash(h, pObject->_oLight);
+		h = RenderHash(h, pObject->_ox - x);
+		h = RenderHash(h, pObject->_oy - y);
+	}
+
+	bv = dItem[x][y];
+	h = RenderHash(h, bv);
+	if (bv != 0) {
+		pItem = &item[bv - 1];
+		h = RenderHash(h, bv - 1 == pcursitem);
+		h = RenderHash(h, (DWORD)(size_t)pItem->_iAnimData);
+		h = RenderHash(h, pItem->_iAnimFrame);
+		h = RenderHash(h, pItem->_iAnimWidth);
+		h = RenderHash(h, pItem->_iAnimWidth2);
+		h = RenderHash(h, pItem->_iPostDraw);
+	}
+
+	for (i = 0; i < 2 && y - i >= 0; i++) {
+		bv = dMonster[x][y - i];
+		h = RenderHash(h, bv);
+		if (bv != 0)
+			h = HashMonster(h, bv > 0 ? bv - 1 : -(bv + 1));
+		bv = dPlayer[x][y - i];
+		h = RenderHash(h, bv);
+		if (bv != 0)
+			h = HashPlayer(h, bv > 0 ? bv - 1 : -(bv + 1));
+	}
+
+	if (bFlag & BFLAG_DEAD_PLAYER) {
+		for (i = 0; i < MAX_PLRS; i++) {
+			pPlayer = &plr[i];
+			if (pPlayer->plractive && !pPlayer->_pHitPoints && pPlayer->plrlevel == (BYTE)currlevel && pPlayer->WorldX == x && pPlayer->WorldY == y)
+				h = HashPlayer(h, i);
+		}
+	}
+
+	if (bFlag & BFLAG_MISSILE) {
+		h = RenderHash(h, dMissile[x][y]);
+		if (dMissile[x][y] != -1) {
+			h = HashMissile(h, &missile[dMissile[x][y] - 1]);
+		} else {
+			for (i = 0; i < nummissiles; i++) {
+				if (missile[missileactive[i]]._mix == x && missile[missileactive[i]]._miy == y)
+					h = HashMissile(h, &missile[missileactive[i]]);
+			}
+		}
+	}
+
+	return h;
+}
+
+/** Rows a band's clip window extends into its neighbours, so outlines bleeding over the edge are kept */
+#define BAND_CLIP_MARGIN 2
+/** Rows next to a band boundary that either band can write */
+#define BAND_EDGE_ROWS 3
+/** Smallest band worth handing to another thread, must leave room for both edges */
+#define MIN_BAND_HEIGHT 16
+
+/**
+ * Rows of the dungeon DrawGame wants drawn and how they are split into
+ * horizontal bands, band k covers the buffer rows band[k] to band[k + 1].
+ */
+typedef struct RenderJob {
+	int x;
+	int y;
+	int sx;
+	int sy;
+	int chunks;
+	int blocks;
+	int phase;
+	int nbands;
+	int band[2 * MAX_RENDER_THREADS + 1];
+} RenderJob;
+
+/** Threads DrawGame splits the viewport between, from the "Render Threads" setting */
+static int sgnRenderThreads;
+static RenderJob sgRenderJob;
+static SDL_sem *sgpRenderStart[MAX_RENDER_THREADS];
+static SDL_sem *sgpRenderDone;
+static HANDLE sghRenderThread[MAX_RENDER_THREADS];
+/** Cleared by scrollrt_cleanup to make the render threads return */
+static BOOL sgbRenderRunning;
+/** Pre-frame and first phase copies of the rows around each band boundary */
+static BYTE *sgpBandEdges[2];
+
+/**
+ * @brief Clip drawing to the buffer rows [top, bottom), widened by BAND_CLIP_MARGIN unless at the edge of the viewport
+ */
+static void SetDrawClip(int top, int bottom)
+{
+	if (top > SCREEN_Y)
+		gpBufStart = &gpBuffer[BUFFER_WIDTH * (top - BAND_CLIP_MARGIN)];
+	else
+		gpBufStart = &gpBuffer[BUFFER_WIDTH * SCREEN_Y];
+	if (bottom < SCREEN_Y + VIEWPORT_HEIGHT)
+		gpBufEnd = &gpBuffer[BUFFER_WIDTH * (bottom + BAND_CLIP_MARGIN)];
+	else
+		gpBufEnd = &gpBuffer[BUFFER_WIDTH * (VIEWPORT_HEIGHT + SCREEN_Y)];
+}
+
+/**
+ * @brief Render the rows of a job that can reach the buffer rows [top, bottom)
+ */
+static void DrawGameRows(const RenderJob *job, int top, int bottom)
+{
+	int i, x, y, sy;
+
+	SetDrawClip(top, bottom);
+
+	x = job->x;
+	y = job->y;
+	sy = job->sy;
+	for (i = 0; i < (job->blocks << 1); i++) {
+		if (sy + CELL_REACH_DOWN >= top - BAND_CLIP_MARGIN && sy - CELL_REACH_UP < bottom + BAND_CLIP_MARGIN)
+			scrollrt_draw(x, y, job->sx, sy, job->chunks, i);
+		sy += 16;
+		if (i & 1)
+			y++;
+		else
+			x++;
+	}
+}
+
+static unsigned int __stdcall render_thread_handler(void *arg)
+{
+	int id, band;
+
+	id = (int)(size_t)arg;
+	SetRenderThread(id);
+
+	while (TRUE) {
+		SDL_SemWait(sgpRenderStart[id]);
+		if (!sgbRenderRunning)
+			break;
+		band = 2 * id + sgRenderJob.phase;
+		DrawGameRows(&sgRenderJob, sgRenderJob.band[band], sgRenderJob.band[band + 1]);
+		SDL_SemPost(sgpRenderDone);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Read the "Render Threads" setting and start the extra threads
+ */
+static void InitRenderThreads()
+{
+	int i, threads;
+	unsigned int id;
+
+	threads = 1;
+	if (!SRegLoadValue("devilutionx", "Render Threads", 0, &threads))
+		SRegSaveValue("devilutionx", "Render Threads", 0, threads);
+	if (threads < 1)
+		threads = 1;
+	if (threads > MAX_RENDER_THREADS)
+		threads = MAX_RENDER_THREADS;
+
+	InitRender(threads);
+	sgnRenderThreads = threads;
+	if (threads == 1)
+		return;
+
+	sgpBandEdges[0] = DiabloAllocPtr(2 * threads * 2 * BAND_EDGE_ROWS * BUFFER_WIDTH);
+	sgpBandEdges[1] = DiabloAllocPtr(2 * threads * 2 * BAND_EDGE_ROWS * BUFFER_WIDTH);
+	sgpRenderDone = SDL_CreateSemaphore(0);
+	if (sgpRenderDone == NULL)
+		app_fatal("render1:\n%s", TraceLastError());
+	sgbRenderRunning = TRUE;
+	for (i = 1; i < threads; i++) {
+		sgpRenderStart[i] = SDL_CreateSemaphore(0);
+		if (sgpRenderStart[i] == NULL)
+			app_fatal("render2:\n%s", TraceLastError());
+		sghRenderThread[i] = (HANDLE)_beginthreadex(NULL, 0, render_thread_handler, (void *)(size_t)i, 0, &id);
+		if (sghRenderThread[i] == INVALID_HANDLE_VALUE)
+			app_fatal("render3:\n%s", TraceLastError());
+	}
+}
+
+/**
+ * @brief Stop and join the render threads, the next DrawGame starts them again
+ */
+void scrollrt_cleanup()
+{
+	int i;
+
+	if (sgnRenderThreads <= 1) {
+		sgnRenderThreads = 0;
+		return;
+	}
+
+	sgbRenderRunning = FALSE;
+	for (i = 1; i < sgnRenderThreads; i++) {
+		SDL_SemPost(sgpRenderStart[i]);
+		if (sghRenderThread[i] != INVALID_HANDLE_VALUE) {
+			if (WaitForSingleObject(sghRenderThread[i], 0xFFFFFFFF) == -1)
+				app_fatal("render4:\n(%s)", TraceLastError());
+			CloseHandle(sghRenderThread[i]);
+			sghRenderThread[i] = INVALID_HANDLE_VALUE;
+		}
+		SDL_DestroySemaphore(sgpRenderStart[i]);
+		sgpRenderStart[i] = NULL;
+	}
+	SDL_DestroySemaphore(sgpRenderDone);
+	sgpRenderDone = NULL;
+	MemFreeDbg(sgpBandEdges[0]);
+	MemFreeDbg(sgpBandEdges[1]);
+	sgnRenderThreads = 0;
+}
+
+/**
+ * @brief Copy the rows around the band boundaries between gpBuffer and save
+ * @param save Room for 2 * BAND_EDGE_ROWS rows per boundary
+ * @param parity Only touch rows of bands with this parity, -1 for all rows
+ * @param restore Copy from save to gpBuffer instead
+ */
+static void CopyBandEdges(const RenderJob *job, BYTE *save, int parity, BOOL restore)
+{
+	int k, r, row;
+	BYTE *dst;
+
+	for (k = 1; k < job->nbands; k++) {
+		r = job->band[k];
+		for (row = r - BAND_EDGE_ROWS; row < r + BAND_EDGE_ROWS; row++, save += BUFFER_WIDTH) {
+			if (parity != -1 && ((row < r ? k - 1 : k) & 1) != parity)
+				continue;
+			dst = &gpBuffer[BUFFER_WIDTH * row];
+			if (restore)
+				memcpy(dst, save, BUFFER_WIDTH);
+			else
+				memcpy(save, dst, BUFFER_WIDTH);
+		}
+	}
+}
+
+/**
+ * @brief Draw every band of one parity, one per thread, and wait for all of them
+ */
+static void RunRenderPhase(int phase)
+{
+	int i, n;
+
+	sgRenderJob.phase = phase;
+	n = (sgRenderJob.nbands - phase + 1) / 2;
+	for (i = 1; i < n; i++)
+		SDL_SemPost(sgpRenderStart[i]);
+	DrawGameRows(&sgRenderJob, sgRenderJob.band[phase], sgRenderJob.band[phase + 1]);
+	for (i = 1; i < n; i++)
+		SDL_SemWait(sgpRenderDone);
+}
+
+/**
+ * @brief Render the dungeon into the buffer rows [top, bottom), split between the render threads
+ *
+ * Neighbouring bands both write the few rows around their boundary, so even and
+ * odd bands are drawn in two phases. The boundary rows are put back between the
+ * phases so each band starts from, and ends with, what a single thread would see.
+ * @param x dPiece coordinate of the first cell
+ * @param y dPiece coordinate of the first cell
+ * @param sx Backbuffer coordinate of the first cell
+ * @param sy Backbuffer coordinate of the first cell
+ * @param chunks tile width of a row
+ * @param blocks number of row pairs
+ * @param top First buffer row to draw
+ * @param bottom Buffer row after the last one to draw
+ */
+static void DrawGameRegion(int x, int y, int sx, int sy, int chunks, int blocks, int top, int bottom)
+{
+	int k, nbands;
+	RenderJob *job;
+
+	job = &sgRenderJob;
+	job->x = x;
+	job->y = y;
+	job->sx = sx;
+	job->sy = sy;
+	job->chunks = chunks;
+	job->blocks = blocks;
+
+	nbands = 2 * sgnRenderThreads;
+	if (nbands > (bottom - top) / MIN_BAND_HEIGHT)
+		nbands = (bottom - top) / MIN_BAND_HEIGHT;
+	if (nbands < 2) {
+		DrawGameRows(job, top, bottom);
+		return;
+	}
+
+	job->nbands = nbands;
+	for (k = 0; k <= nbands; k++)
+		job->band[k] = top + (bottom - top) * k / nbands;
+
+	CopyBandEdges(job, sgpBandEdges[0], -1, FALSE);
+	RunRenderPhase(0);
+	CopyBandEdges(job, sgpBandEdges[1], 0, FALSE);
+	CopyBandEdges(job, sgpBandEdges[0], 1, TRUE);
+	RunRenderPhase(1);
+	CopyBandEdges(job, sgpBandEdges[1], 0, TRUE);
+}
+
+/**
+ * @brief Render the dungeon, but only the bands whose cells changed since the last frame
+ *
+ * Each row of cells is hashed and the hash is folded into every band the row can draw
+ * into. Rows that can't reach a changed band are skipped, and bands that didn't change
+ * are copied back from the game layer so panels and the cursor from the previous frame
+ * never leak into it.
+ * @param x dPiece coordinate of the first cell
+ * @param y dPiece coordinate of the first cell
+ * @param sx Backbuffer coordinate of the first cell
+ * @param sy Backbuffer coordinate of the first cell
+ * @param chunks tile width of a row
+ * @param blocks number of row pairs
+ */
+static void DrawGameIncremental(int x, int y, int sx, int sy, int chunks, int blocks)
+{
+	int i, j, b, cx, cy, csx, top, bottom, y0, y1;
+	unsigned long long seed, h, hash[VIEWPORT_BANDS];
+	BOOL dirty[VIEWPORT_BANDS];
+	BYTE *layer, *dst;
+
+	seed = 14695981039346656037ULL;
+	seed = RenderHash(seed, x);
+	seed = RenderHash(seed, y);
+	seed = RenderHash(seed, sx);
+	seed = RenderHash(seed, sy);
+	seed = RenderHash(seed, chunks);
+	seed = RenderHash(seed, blocks);
+	seed = RenderHash(seed, leveltype);
+	seed = RenderHash(seed, currlevel);
+	seed = RenderHash(seed, setlevel);
+	seed = RenderHash(seed, setlvlnum);
+	seed = RenderHash(seed, myplr);
+	seed = RenderHash(seed, plr[myplr]._pInfraFlag);
+	seed = RenderHash(seed, visiondebug);
+	seed = RenderHash(seed, lightmax);
+	seed = RenderHash(seed, MissilePreFlag);
+	seed = RenderHash(seed, tile_cache_generation);
+#ifdef _DEBUG
+	seed = RenderHash(seed, GetAsyncKeyState(VK_MENU) & 0x8000);
+#endif
+	for (b = 0; b < VIEWPORT_BANDS; b++)
+		hash[b] = seed;
+
+	for (i = 0; i < (blocks << 1); i++) {
+		cx = x;
+		cy = y;
+		csx = sx;
+		j = chunks;
+		if (i & 1) {
+			cx--;
+			cy++;
+			csx -= 32;
+			j++;
+		}
+		// Start two cells early, those can still be redrawn by the e-flag workaround
+		cx -= 2;
+		cy += 2;
+		csx -= 128;
+		j += 2;
+		h = RenderHash(seed, sy + 16 * i);
+		for (; j != 0; j--, cx++, cy--, csx += 64) {
+			h = RenderHash(h, csx);
+			h ^= HashCell(cx, cy);
+		}
+
+		top = (sy + 16 * i - CELL_REACH_UP - SCREEN_Y) / VIEWPORT_BAND_HEIGHT;
+		bottom = (sy + 16 * i + CELL_REACH_DOWN - SCREEN_Y) / VIEWPORT_BAND_HEIGHT;
+		if (top < 0)
+			top = 0;
+		for (b = top; b <= bottom && b < VIEWPORT_BANDS; b++)
+			hash[b] = RenderHash(hash[b] ^ h, b);
+
+		if (i & 1)
+			y++;
+		else
+			x++;
+	}
+	x -= blocks;
+	y -= blocks;
+
+	top = VIEWPORT_BANDS;
+	bottom = -1;
+	for (b = 0; b < VIEWPORT_BANDS; b++) {
+		dirty[b] = !sgbGameLayerValid || hash[b] != sgBandHash[b];
+		sgBandHash[b] = hash[b];
+		if (dirty[b]) {
+			if (top > b)
+				top = b;
+			bottom = b;
+		}
+	}
+
+	if (bottom >= 0) {
+		y0 = SCREEN_Y + top * VIEWPORT_BAND_HEIGHT;
+		y1 = SCREEN_Y + (bottom + 1) * VIEWPORT_BAND_HEIGHT;
+		if (y1 > SCREEN_Y + VIEWPORT_HEIGHT)
+			y1 = SCREEN_Y + VIEWPORT_HEIGHT;
+		DrawGameRegion(x, y, sx, sy, chunks, blocks, y0, y1);
+	}
+
+	layer = sgpGameLayer;
+	dst = &gpBuffer[BUFFER_WIDTH * SCREEN_Y];
+	for (b = 0; b < VIEWPORT_BANDS; b++) {
+		j = VIEWPORT_BAND_HEIGHT;
+		if (b == VIEWPORT_BANDS - 1)
+			j = VIEWPORT_HEIGHT - b * VIEWPORT_BAND_HEIGHT;
+		if (dirty[b])
+			memcpy(layer, dst, j * BUFFER_WIDTH);
+		else
+			memcpy(dst, layer, j * BUFFER_WIDTH);
+		layer += j * BUFFER_WIDTH;
+		dst += j * BUFFER_WIDTH;
+	}
+	sgbGameLayerValid = TRUE;
+}
+
 /**
  * @brief Configure render and process screen rows
  * @param x Center of view in dPiece coordinate
@@ -816,13 +1375,26 @@ static void DrawGame(int x, int y)
 		break;
 	}
 
-	for (i = 0; i < (blocks << 1); i++) {
-		scrollrt_draw(x, y, sx, sy, chunks, i);
-		sy += 16;
-		if (i & 1)
-			y++;
-		else
-			x++;
+	if (!sgbIncrementalInit)
+		InitIncrementalRedraw();
+	if (sgnRenderThreads == 0)
+		InitRenderThreads();
+
+	if (zoomflag && sgbIncrementalRedraw) {
+		DrawGameIncremental(x, y, sx, sy, chunks, blocks);
+	} else if (zoomflag && sgnRenderThreads > 1) {
+		sgbGameLayerValid = FALSE;
+		DrawGameRegion(x, y, sx, sy, chunks, blocks, SCREEN_Y, SCREEN_Y + VIEWPORT_HEIGHT);
+	} else {
+		sgbGameLayerValid = FALSE;
+		for (i = 0; i < (blocks << 1); i++) {
+			scrollrt_draw(x, y, sx, sy, chunks, i);
+			sy += 16;
+			if (i & 1)
+				y++;
+			else
+				x++;
+		}
 	}
 	gpBufStart = &gpBuffer[BUFFER_WIDTH * SCREEN_Y];
 	gpBufEnd = &gpBuffer[BUFFER_WIDTH * (SCREEN_HEIGHT + SCREEN_Y)];
@@ -870,7 +1442,10 @@ static void DrawGame(int x, int y)
  */
 void DrawView(int StartX, int StartY)
 {
+	profile_begin(PROF_DRAWVIEW);
+	profile_begin(PROF_DRAWGAME);
 	DrawGame(StartX, StartY);
+	profile_end(PROF_DRAWGAME);
 	if (automapflag) {
 		DrawAutomap();
 	}
@@ -922,6 +1497,7 @@ void DrawView(int StartX, int StartY)
 	DrawInfoBox();
 	DrawLifeFlask();
 	DrawManaFlask();
+	profile_end(PROF_DRAWVIEW);
 }
 
 /**
@@ -1042,9 +1618,13 @@ void EnableFrameCount()
  */
 static void DrawFPS()
 {
-	DWORD tc, frames;
-	char String[12];
+	DWORD tc, frames, lookups, hits, misses, loaded, cached;
+	DWORD presented, busy, dropped, gap;
+	char String[40];
 	HDC hdc;
+	static DWORD lastHits, lastMisses, tileHitRate;
+	static DWORD fileHitRate, fileCachedKB;
+	static DWORD lastPresented, lastBusy, lastDropped, presentMs, presentDropped, presentGap;
 
 	if (frameflag && gbActive && pPanelText) {
 		frameend++;
@@ -1054,11 +1634,36 @@ static void DrawFPS()
 			framestart = tc;
 			framerate = 1000 * frameend / frames;
 			frameend = 0;
+			GetTileCacheStats(&hits, &misses);
+			lookups = (hits - lastHits) + (misses - lastMisses);
+			tileHitRate = lookups != 0 ? 100 * (hits - lastHits) / lookups : 0;
+			lastHits = hits;
+			lastMisses = misses;
+			GetFileViewStats(&hits, &misses, &loaded, &cached);
+			fileHitRate = hits + misses != 0 ? 100 * hits / (hits + misses) : 0;
+			fileCachedKB = cached / 1024;
+			GetPresentStats(&presented, &busy, &dropped, &gap);
+			presentMs = presented != lastPresented ? (busy - lastBusy) / (presented - lastPresented) : 0;
+			presentDropped = dropped - lastDropped;
+			presentGap = gap;
+			lastPresented = presented;
+			lastBusy = busy;
+			lastDropped = dropped;
 		}
 		if (framerate > 99)
 			framerate = 99;
 		wsprintf(String, "%2d FPS", framerate);
 		PrintGameStr(8, 65, String, COL_RED);
+		if (lastHits + lastMisses != 0) {
+			wsprintf(String, "%d%% tiles", tileHitRate);
+			PrintGameStr(8, 80, String, COL_RED);
+		}
+		wsprintf(String, "%d%% files, %dk cached", fileHitRate, fileCachedKB);
+		PrintGameStr(8, 95, String, COL_RED);
+		if (lastPresented != 0) {
+			wsprintf(String, "%d ms present, %d ms gap, %d dropped", presentMs, presentGap, presentDropped);
+			PrintGameStr(8, 110, String, COL_RED);
+		}
 	}
 }
 
@@ -1081,6 +1686,57 @@ static void DoBlitScreen(DWORD dwX, DWORD dwY, DWORD dwWdt, DWORD dwHgt)
 	BltFast(dwX, dwY, &SrcRect);
 }
 
+/**
+ * @brief Blit the viewport bands that differ from what was last blitted
+ * @return FALSE if incremental redraw is off and the caller has to blit the viewport itself
+ */
+static BOOL BlitViewportBands()
+{
+	int b, i, hgt, top;
+	BOOL changed;
+	BYTE *src, *copy;
+
+	if (!sgbIncrementalRedraw)
+		return FALSE;
+
+	src = &gpBuffer[SCREENXY(0, 0)];
+	copy = sgpBlitCopy;
+
+	if (!sgbBlitCopyValid || sgdwBlitPalVersion != pal_surface_palette_version) {
+		DoBlitScreen(0, 0, SCREEN_WIDTH, VIEWPORT_HEIGHT);
+		for (i = 0; i < VIEWPORT_HEIGHT; i++, src += BUFFER_WIDTH, copy += SCREEN_WIDTH)
+			memcpy(copy, src, SCREEN_WIDTH);
+		sgbBlitCopyValid = TRUE;
+		sgdwBlitPalVersion = pal_surface_palette_version;
+		return TRUE;
+	}
+
+	top = -1;
+	for (b = 0; b < VIEWPORT_BANDS; b++) {
+		hgt = VIEWPORT_BAND_HEIGHT;
+		if (b == VIEWPORT_BANDS - 1)
+			hgt = VIEWPORT_HEIGHT - b * VIEWPORT_BAND_HEIGHT;
+		changed = FALSE;
+		for (i = 0; i < hgt; i++, src += BUFFER_WIDTH, copy += SCREEN_WIDTH) {
+			if (memcmp(copy, src, SCREEN_WIDTH) != 0) {
+				memcpy(copy, src, SCREEN_WIDTH);
+				changed = TRUE;
+			}
+		}
+		if (changed) {
+			if (top == -1)
+				top = b;
+		} else if (top != -1) {
+			DoBlitScreen(0, top * VIEWPORT_BAND_HEIGHT, SCREEN_WIDTH, (b - top) * VIEWPORT_BAND_HEIGHT);
+			top = -1;
+		}
+	}
+	if (top != -1)
+		DoBlitScreen(0, top * VIEWPORT_BAND_HEIGHT, SCREEN_WIDTH, VIEWPORT_HEIGHT - top * VIEWPORT_BAND_HEIGHT);
+
+	return TRUE;
+}
+
 /**
  * @brief Check render pipline and blit indivudal screen parts
  * @param dwHgt Section of screen to update from top to bottom
@@ -1104,8 +1760,13 @@ static void DrawMain(int dwHgt, BOOL draw_desc, BOOL draw_hp, BOOL draw_mana, BO
 
 	assert(ysize >= 0 && ysize <= SCREEN_HEIGHT);
 
-	if (ysize > 0) {
+	if (ysize >= VIEWPORT_HEIGHT && BlitViewportBands()) {
+		if (ysize > VIEWPORT_HEIGHT) {
+			DoBlitScreen(0, VIEWPORT_HEIGHT, SCREEN_WIDTH, ysize - VIEWPORT_HEIGHT);
+		}
+	} else if (ysize > 0) {
 		DoBlitScreen(0, 0, SCREEN_WIDTH, ysize);
+		sgbBlitCopyValid = FALSE;
 	}
 	if (ysize < SCREEN_HEIGHT) {
 		if (draw_sbar) {
@@ -1148,6 +1809,7 @@ void scrollrt_draw_game_screen(BOOL draw_cursor)
 	} else {
 		hgt = 0;
 	}
+	sgbBlitCopyValid = FALSE;
 
 	if (draw_cursor) {
 		lock_buf(0);
@@ -1176,6 +1838,13 @@ void DrawAndBlit()
 		return;
 	}
 
+	dx_present_start();
+
+	if (force_redraw == 255) {
+		sgbGameLayerValid = FALSE;
+		sgbBlitCopyValid = FALSE;
+	}
+
 	if (SCREEN_WIDTH > PANEL_WIDTH || SCREEN_HEIGHT > VIEWPORT_HEIGHT + PANEL_HEIGHT || force_redraw == 255) {
 		drawhpflag = TRUE;
 		drawmanaflag = TRUE;
@@ -1216,6 +1885,7 @@ void DrawAndBlit()
 	scrollrt_draw_cursor_item();
 
 	DrawFPS();
+	profile_draw();
 
 	unlock_buf(0);
 
@@ -1229,6 +1899,8 @@ void DrawAndBlit()
 	drawmanaflag = FALSE;
 	drawbtnflag = FALSE;
 	drawsbarflag = FALSE;
+
+	profile_frame();
 }
 
 DEVILUTION_END_NAMESPACE
@@ -2,13 +2,13 @@
 #ifndef __SCROLLRT_H__
 #define __SCROLLRT_H__
 
-extern int light_table_index;
-extern BYTE *gpBufStart;
-extern BYTE *gpBufEnd;
-extern DWORD level_cel_block;
-extern char arch_draw_type;
-extern int cel_transparency_active;
-extern int level_piece_id;
+extern thread_local int light_table_index;
+extern thread_local BYTE *gpBufStart;
+extern thread_local BYTE *gpBufEnd;
+extern thread_local DWORD level_cel_block;
+extern thread_local char arch_draw_type;
+extern thread_local int cel_transparency_active;
+extern thread_local int level_piece_id;
 extern void (*DrawPlrProc)(int, int, int, int, int, BYTE *, int, int, int, int);
 
 void ClearCursor();
@@ -22,6 +22,7 @@ void ScrollView();
 void EnableFrameCount();
 void scrollrt_draw_game_screen(BOOL draw_cursor);
 void DrawAndBlit();
+void scrollrt_cleanup();
 
 /* rdata */
 
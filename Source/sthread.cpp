@@ -0,0 +1,334 @@
+#include "diablo.h"
+#include "../3rdParty/Storm/Source/storm.h"
+
+DEVILUTION_BEGIN_NAMESPACE
+
+enum save_job_type {
+	SAVE_JOB_FILE,
+	SAVE_JOB_HERO,
+};
+
+/** One save, snapshotted on the game thread and committed by the save thread */
+typedef struct TSaveJob {
+	struct TSaveJob *pNext;
+	int type;
+	/** Game type as of queuing, the game thread may be in another game by the time it is written */
+	BOOL bSinglePlayer;
+	DWORD save_num;
+	char szName[MAX_PATH];
+	BYTE *pbData;
+	DWORD dwLen;
+	DWORD qwLen;
+	PkPlayerStruct pkplr;
+	BOOL bSuccess;
+	DWORD dwTicks;
+} TSaveJob;
+
+/** Protects everything below that the save thread also touches */
+static SDL_mutex *sgpSaveMutex;
+/** Signalled when a job is queued */
+static SDL_cond *sgpSaveWork;
+/** Signalled when a job is finished */
+static SDL_cond *sgpSaveDone;
+/** Jobs waiting for the save thread, oldest first */
+static TSaveJob *sgpSaveHead;
+static TSaveJob *sgpSaveTail;
+/** Jobs finished but not yet reported to the callbacks */
+static TSaveJob *sgpSaveFinished;
+/** Queued jobs plus the one being committed */
+static int sgnSaveJobs;
+static DWORD sgdwSaveWork[SAVE_HIST_BUCKETS];
+static DWORD sgdwSaveStall[SAVE_HIST_BUCKETS];
+static SAVECALLBACK sgfnSaveDone;
+static SAVECALLBACK sgfnSaveFail;
+static BOOLEAN sgbSaveInit;
+/** Commit saves on the save thread, otherwise in place as before */
+static BOOLEAN sgbSaveThread;
+/** Set by sthread_cleanup, the save thread returns once the queue is empty */
+static BOOLEAN sgbSaveQuit;
+static HANDLE sghSaveThread;
+static unsigned int sgdwSaveThreadId;
+
+static void sthread_record(DWORD *pdwHist, DWORD dwTicks)
+{
+	int i;
+
+	for (i = 0; i < SAVE_HIST_BUCKETS - 1 && dwTicks >= (1u << i); i++)
+		;
+	pdwHist[i]++;
+}
+
+/**
+ * @brief Read the "Background Saves" setting and start the save thread
+ */
+static void sthread_init()
+{
+	int value;
+
+	sgbSaveInit = TRUE;
+	value = 1;
+	if (!SRegLoadValue("devilutionx", "Background Saves", 0, &value))
+		SRegSaveValue("devilutionx", "Background Saves", 0, value);
+	if (value == 0)
+		return;
+
+	sgpSaveMutex = SDL_CreateMutex();
+	sgpSaveWork = SDL_CreateCond();
+	sgpSaveDone = SDL_CreateCond();
+	if (sgpSaveMutex == NULL || sgpSaveWork == NULL || sgpSaveDone == NULL)
+		app_fatal("sthread1:\n%s", TraceLastError());
+	sghSaveThread = (HANDLE)_beginthreadex(NULL, 0, sthread_handler, NULL, 0, &sgdwSaveThreadId);
+	if (sghSaveThread == INVALID_HANDLE_VALUE)
+		app_fatal("sthread2:\n%s", TraceLastError());
+	sgbSaveThread = TRUE;
+}
+
+static void sthread_run(TSaveJob *job)
+{
+	DWORD dwStart;
+
+	dwStart = GetTickCount();
+	if (job->type == SAVE_JOB_FILE) {
+		job->bSuccess = pfile_commit_save_file(job->szName, job->pbData, job->dwLen, job->qwLen, job->bSinglePlayer, job->save_num);
+		MemFreeDbg(job->pbData);
+	} else {
+		job->bSuccess = pfile_commit_hero(&job->pkplr, job->bSinglePlayer, job->save_num);
+	}
+	job->dwTicks = GetTickCount() - dwStart;
+}
+
+/**
+ * @brief Queue a job, waiting for room if the save thread is MAX_SAVE_JOBS behind
+ */
+static void sthread_queue(TSaveJob *job)
+{
+	DWORD dwStart;
+
+	job->pNext = NULL;
+	if (!sgbSaveThread) {
+		sthread_run(job);
+		sthread_record(sgdwSaveWork, job->dwTicks);
+		job->pNext = sgpSaveFinished;
+		sgpSaveFinished = job;
+		sthread_poll();
+		return;
+	}
+
+	SDL_LockMutex(sgpSaveMutex);
+	if (sgnSaveJobs >= MAX_SAVE_JOBS) {
+		dwStart = GetTickCount();
+		while (sgnSaveJobs >= MAX_SAVE_JOBS)
+			SDL_CondWait(sgpSaveDone, sgpSaveMutex);
+		sthread_record(sgdwSaveStall, GetTickCount() - dwStart);
+	}
+	if (sgpSaveTail != NULL)
+		sgpSaveTail->pNext = job;
+	else
+		sgpSaveHead = job;
+	sgpSaveTail = job;
+	sgnSaveJobs++;
+	SDL_CondSignal(sgpSaveWork);
+	SDL_UnlockMutex(sgpSaveMutex);
+}
+
+unsigned int __stdcall sthread_handler(void *)
+{
+	TSaveJob *job;
+
+	SDL_LockMutex(sgpSaveMutex);
+	while (TRUE) {
+		while (sgpSaveHead == NULL && !sgbSaveQuit)
+			SDL_CondWait(sgpSaveWork, sgpSaveMutex);
+		if (sgpSaveHead == NULL)
+			break;
+		job = sgpSaveHead;
+		sgpSaveHead = job->pNext;
+		if (sgpSaveHead == NULL)
+			sgpSaveTail = NULL;
+		SDL_UnlockMutex(sgpSaveMutex);
+
+		sthread_run(job);
+
+		SDL_LockMutex(sgpSaveMutex);
+		sthread_record(sgdwSaveWork, job->dwTicks);
+		job->pNext = sgpSaveFinished;
+		sgpSaveFinished = job;
+		sgnSaveJobs--;
+		SDL_CondBroadcast(sgpSaveDone);
+	}
+	SDL_UnlockMutex(sgpSaveMutex);
+
+	return 0;
+}
+
+/**
+ * @brief Set the functions told about finished saves, either may be NULL
+ */
+void sthread_set_callbacks(SAVECALLBACK fnDone, SAVECALLBACK fnFail)
+{
+	sgfnSaveDone = fnDone;
+	sgfnSaveFail = fnFail;
+}
+
+/**
+ * @brief Queue a save file to be encoded and written into the save archive
+ * @param pbData Buffer of qwLen bytes holding dwLen bytes of save data, freed once written
+ */
+void sthread_save_file(const char *pszName, BYTE *pbData, DWORD dwLen, DWORD qwLen, DWORD save_num)
+{
+	TSaveJob *job;
+
+	if (!sgbSaveInit)
+		sthread_init();
+
+	job = (TSaveJob *)DiabloAllocPtr(sizeof(*job));
+	job->type = SAVE_JOB_FILE;
+	job->bSinglePlayer = gbMaxPlayers == 1;
+	job->save_num = save_num;
+	SStrCopy(job->szName, pszName, sizeof(job->szName));
+	job->pbData = pbData;
+	job->dwLen = dwLen;
+	job->qwLen = qwLen;
+	sthread_queue(job);
+}
+
+/**
+ * @brief Queue a hero to be written into its save archive
+ *
+ * A hero still waiting in the queue for the same archive is updated in place,
+ * so periodic saves never pile up behind a slow disk.
+ */
+void sthread_save_hero(const PkPlayerStruct *pPack, DWORD save_num)
+{
+	TSaveJob *job;
+
+	if (!sgbSaveInit)
+		sthread_init();
+
+	if (sgbSaveThread) {
+		SDL_LockMutex(sgpSaveMutex);
+		for (job = sgpSaveHead; job != NULL; job = job->pNext) {
+			if (job->type == SAVE_JOB_HERO && job->bSinglePlayer == (gbMaxPlayers == 1) && job->save_num == save_num) {
+				memcpy(&job->pkplr, pPack, sizeof(*pPack));
+				SDL_UnlockMutex(sgpSaveMutex);
+				return;
+			}
+		}
+		SDL_UnlockMutex(sgpSaveMutex);
+	}
+
+	job = (TSaveJob *)DiabloAllocPtr(sizeof(*job));
+	job->type = SAVE_JOB_HERO;
+	job->bSinglePlayer = gbMaxPlayers == 1;
+	job->save_num = save_num;
+	SStrCopy(job->szName, "hero", sizeof(job->szName));
+	job->pbData = NULL;
+	memcpy(&job->pkplr, pPack, sizeof(*pPack));
+	sthread_queue(job);
+}
+
+/**
+ * @brief Report finished saves to the callbacks, on the game thread
+ */
+void sthread_poll()
+{
+	TSaveJob *job, *done, *next;
+
+	if (sgbSaveThread)
+		SDL_LockMutex(sgpSaveMutex);
+	done = NULL;
+	for (job = sgpSaveFinished; job != NULL; job = next) {
+		next = job->pNext;
+		job->pNext = done;
+		done = job;
+	}
+	sgpSaveFinished = NULL;
+	if (sgbSaveThread)
+		SDL_UnlockMutex(sgpSaveMutex);
+
+	for (job = done; job != NULL; job = next) {
+		next = job->pNext;
+		if (job->bSuccess) {
+			if (sgfnSaveDone != NULL)
+				sgfnSaveDone(job->szName, job->dwTicks);
+		} else {
+			pfile_save_failed(job->szName);
+			if (sgfnSaveFail != NULL)
+				sgfnSaveFail(job->szName, job->dwTicks);
+		}
+		mem_free_dbg(job);
+	}
+}
+
+/**
+ * @brief Block until every queued save is on disk
+ *
+ * Anything that opens a save archive on the game thread calls this first, the
+ * save thread owns the archive state in mpqapi.cpp while it has work.
+ */
+void sthread_wait()
+{
+	DWORD dwStart;
+
+	if (!sgbSaveThread)
+		return;
+
+	SDL_LockMutex(sgpSaveMutex);
+	if (sgnSaveJobs != 0) {
+		dwStart = GetTickCount();
+		while (sgnSaveJobs != 0)
+			SDL_CondWait(sgpSaveDone, sgpSaveMutex);
+		sthread_record(sgdwSaveStall, GetTickCount() - dwStart);
+	}
+	SDL_UnlockMutex(sgpSaveMutex);
+	sthread_poll();
+}
+
+/**
+ * @brief Write out every queued save and stop the save thread
+ *
+ * Saves queued afterwards are committed in place on the calling thread.
+ */
+void sthread_cleanup()
+{
+	if (!sgbSaveThread)
+		return;
+	// app_fatal on the save thread itself, it can't wait for its own queue
+	if (sgdwSaveThreadId == GetCurrentThreadId())
+		return;
+
+	SDL_LockMutex(sgpSaveMutex);
+	sgbSaveQuit = TRUE;
+	SDL_CondSignal(sgpSaveWork);
+	SDL_UnlockMutex(sgpSaveMutex);
+	if (WaitForSingleObject(sghSaveThread, 0xFFFFFFFF) == -1)
+		app_fatal("sthread3:\n(%s)", TraceLastError());
+	CloseHandle(sghSaveThread);
+	sghSaveThread = INVALID_HANDLE_VALUE;
+
+	sgbSaveThread = FALSE;
+	SDL_DestroyCond(sgpSaveWork);
+	SDL_DestroyCond(sgpSaveDone);
+	SDL_DestroyMutex(sgpSaveMutex);
+	sgpSaveWork = NULL;
+	sgpSaveDone = NULL;
+	sgpSaveMutex = NULL;
+	sthread_poll();
+}
+
+/**
+ * @brief Copy out the save timing histograms, SAVE_HIST_BUCKETS entries each
+ * @param pdwWork Time spent committing each save
+ * @param pdwStall Time the game thread spent waiting on the save thread
+ */
+void sthread_get_histogram(DWORD *pdwWork, DWORD *pdwStall)
+{
+	if (sgbSaveThread)
+		SDL_LockMutex(sgpSaveMutex);
+	memcpy(pdwWork, sgdwSaveWork, sizeof(sgdwSaveWork));
+	memcpy(pdwStall, sgdwSaveStall, sizeof(sgdwSaveStall));
+	if (sgbSaveThread)
+		SDL_UnlockMutex(sgpSaveMutex);
+}
+
+DEVILUTION_END_NAMESPACE
@@ -0,0 +1,17 @@
+//HEADER_GOES_HERE
+#ifndef __STHREAD_H__
+#define __STHREAD_H__
+
+/** Called on the game thread once a queued save is on disk, or failed to get there */
+typedef void (*SAVECALLBACK)(const char *pszName, DWORD dwTicks);
+
+void sthread_set_callbacks(SAVECALLBACK fnDone, SAVECALLBACK fnFail);
+void sthread_save_file(const char *pszName, BYTE *pbData, DWORD dwLen, DWORD qwLen, DWORD save_num);
+void sthread_save_hero(const PkPlayerStruct *pPack, DWORD save_num);
+void sthread_poll();
+void sthread_wait();
+void sthread_cleanup();
+void sthread_get_histogram(DWORD *pdwWork, DWORD *pdwStall);
+unsigned int __stdcall sthread_handler(void *);
+
+#endif /* __STHREAD_H__ */
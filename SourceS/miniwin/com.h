@@ -7,7 +7,7 @@ struct IDirectSoundBuffer {
 	virtual void GetStatus(LPDWORD pdwStatus) = 0;
 	virtual void Play(int lVolume, int lPan) = 0;
 	virtual void Stop() = 0;
-	virtual int SetChunk(BYTE *fileData, DWORD dwBytes) = 0;
+	virtual int SetSamples(BYTE *pcmData, DWORD dwBytes) = 0;
 };
 
 typedef IDirectSoundBuffer *LPDIRECTSOUNDBUFFER;
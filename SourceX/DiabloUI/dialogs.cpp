@@ -311,6 +311,8 @@ void DialogLoop(UiItem *items, std::size_t num_items, UiItem *render_behind, std
 void UiOkDialog(const char *text, const char *caption, bool error, UiItem *render_behind, std::size_t render_behind_size)
 {
 #ifndef VITA
+	// the dialog draws and pumps events itself, the next game frame hands the renderer back
+	dx_present_stop();
 	if (!gbActive) {
 		if (SDL_ShowCursor(SDL_ENABLE) <= -1) {
 			SDL_Log(SDL_GetError());
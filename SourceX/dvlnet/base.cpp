@@ -102,7 +102,7 @@ bool base::SNetReceiveMessage(int *sender, char **data, int *size)
 	poll();
 	if (message_queue.empty())
 		return false;
-	message_last = message_queue.front();
+	message_last = std::move(message_queue.front());
 	message_queue.pop_front();
 	*sender = message_last.sender;
 	*size = message_last.payload.size();
@@ -125,7 +125,7 @@ bool base::SNetSendMessage(int playerID, void *data, unsigned int size)
 	else
 		dest = playerID;
 	if (dest != plr_self) {
-		auto pkt = pktfty->make_packet<PT_MESSAGE>(plr_self, dest, message);
+		auto pkt = pktfty->make_packet<PT_MESSAGE>(plr_self, dest, std::move(message));
 		send(*pkt);
 	}
 	return true;
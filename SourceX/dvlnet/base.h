@@ -60,7 +60,7 @@ protected:
 		}
 		message_t(int s, buffer_t p)
 			: sender(s)
-			, payload(p)
+			, payload(std::move(p))
 		{
 		}
 	};
@@ -7,39 +7,51 @@
 namespace dvl {
 namespace net {
 
+std::array<asio::const_buffer, 2> frame::buffers() const
+{
+	return { { asio::buffer(&size, sizeof(size)), asio::buffer(payload) } };
+}
+
 framesize_t frame_queue::size()
 {
 	return current_size;
 }
 
-buffer_t frame_queue::read(framesize_t s)
+void frame_queue::read(unsigned char *dest, size_t s)
 {
 	if (current_size < s)
 		throw frame_queue_exception();
-	buffer_t ret;
-	while (s > 0 && s >= buffer_deque.front().size()) {
-		s -= buffer_deque.front().size();
-		current_size -= buffer_deque.front().size();
-		ret.insert(ret.end(),
-			buffer_deque.front().begin(),
-			buffer_deque.front().end());
-		buffer_deque.pop_front();
-	}
-	if (s > 0) {
-		ret.insert(ret.end(),
-			buffer_deque.front().begin(),
-			buffer_deque.front().begin() + s);
-		buffer_deque.front().erase(buffer_deque.front().begin(),
-			buffer_deque.front().begin() + s);
-		current_size -= s;
-	}
-	return ret;
+	size_t first = capacity - head;
+	if (first > s)
+		first = s;
+	std::memcpy(dest, &ring[head], first);
+	std::memcpy(dest + first, &ring[0], s - first);
+	head = (head + s) % capacity;
+	current_size -= s;
+	if (!current_size)
+		head = 0; // keep the free space contiguous
+}
+
+unsigned char *frame_queue::write_pos()
+{
+	return &ring[(head + current_size) % capacity];
 }
 
-void frame_queue::write(buffer_t buf)
+size_t frame_queue::write_space()
 {
-	current_size += buf.size();
-	buffer_deque.push_back(std::move(buf));
+	size_t tail = (head + current_size) % capacity;
+	if (current_size == capacity)
+		throw frame_queue_exception();
+	if (tail < head)
+		return head - tail;
+	return capacity - tail;
+}
+
+void frame_queue::commit(size_t s)
+{
+	if (s > capacity - current_size)
+		throw frame_queue_exception();
+	current_size += s;
 }
 
 bool frame_queue::packet_ready()
@@ -47,9 +59,8 @@ bool frame_queue::packet_ready()
 	if (!nextsize) {
 		if (size() < sizeof(framesize_t))
 			return false;
-		auto szbuf = read(sizeof(framesize_t));
-		std::memcpy(&nextsize, &szbuf[0], sizeof(framesize_t));
-		if (!nextsize)
+		read(reinterpret_cast<unsigned char *>(&nextsize), sizeof(framesize_t));
+		if (!nextsize || nextsize > max_frame_size)
 			throw frame_queue_exception();
 	}
 	if (size() >= nextsize)
@@ -62,19 +73,19 @@ buffer_t frame_queue::read_packet()
 {
 	if (!nextsize || (size() < nextsize))
 		throw frame_queue_exception();
-	auto ret = read(nextsize);
+	buffer_t ret(nextsize);
+	read(ret.data(), nextsize);
 	nextsize = 0;
 	return ret;
 }
 
-buffer_t frame_queue::make_frame(buffer_t packetbuf)
+std::shared_ptr<const frame> frame_queue::make_frame(const buffer_t &packetbuf)
 {
-	buffer_t ret;
 	if (packetbuf.size() > max_frame_size)
 		ABORT();
-	framesize_t size = packetbuf.size();
-	ret.insert(ret.end(), packet_out::begin(size), packet_out::end(size));
-	ret.insert(ret.end(), packetbuf.begin(), packetbuf.end());
+	auto ret = std::make_shared<frame>();
+	ret->size = packetbuf.size();
+	ret->payload = packetbuf;
 	return ret;
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <deque>
+#include <array>
+#include <memory>
+#include <asio/ts/buffer.hpp>
 
 #include "dvlnet/abstract_net.h"
 
@@ -12,24 +14,39 @@ class frame_queue_exception : public dvlnet_exception {
 
 typedef uint32_t framesize_t;
 
+// outgoing frame, kept alive by the pending write(s) that send it
+struct frame {
+	framesize_t size;
+	buffer_t payload;
+
+	// length prefix and payload, sent without concatenating them
+	std::array<asio::const_buffer, 2> buffers() const;
+};
+
 class frame_queue {
 public:
 	constexpr static framesize_t max_frame_size = 0xFFFF;
+	// holds a partial frame (with its prefix) plus at least one more read
+	constexpr static size_t capacity = 0x20000;
 
 private:
-	framesize_t current_size = 0;
-	std::deque<buffer_t> buffer_deque;
+	buffer_t ring = buffer_t(capacity);
+	size_t head = 0;
+	size_t current_size = 0;
 	framesize_t nextsize = 0;
 
 	framesize_t size();
-	buffer_t read(framesize_t s);
+	void read(unsigned char *dest, size_t s);
 
 public:
+	unsigned char *write_pos();
+	size_t write_space();
+	void commit(size_t s);
+
 	bool packet_ready();
 	buffer_t read_packet();
-	void write(buffer_t buf);
 
-	static buffer_t make_frame(buffer_t packetbuf);
+	static std::shared_ptr<const frame> make_frame(const buffer_t &packetbuf);
 };
 
 } // namespace net
@@ -18,7 +18,7 @@ bool loopback::SNetReceiveMessage(int *sender, char **data, int *size)
 {
 	if (message_queue.empty())
 		return false;
-	message_last = message_queue.front();
+	message_last = std::move(message_queue.front());
 	message_queue.pop();
 	*sender = plr_single;
 	*size = message_last.size();
@@ -31,7 +31,7 @@ bool loopback::SNetSendMessage(int dest, void *data, unsigned int size)
 	if (dest == plr_single || dest == SNPLAYER_ALL) {
 		auto raw_message = reinterpret_cast<unsigned char *>(data);
 		buffer_t message(raw_message, raw_message + size);
-		message_queue.push(message);
+		message_queue.push(std::move(message));
 	}
 	return true;
 }
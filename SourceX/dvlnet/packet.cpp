@@ -98,7 +98,16 @@ void packet_in::create(buffer_t buf)
 	have_encrypted = true;
 }
 
-void packet_in::decrypt()
+void packet_in::reuse(const unsigned char *data, size_t len)
+{
+	// the buffers keep their capacity from earlier packets, the copy is
+	// kept as forwarded packets are sent from it
+	have_decrypted = false;
+	encrypted_buffer.assign(data, data + len);
+	have_encrypted = true;
+}
+
+void packet_in::decrypt(buffer_t &scratch)
 {
 	if (!have_encrypted)
 		ABORT();
@@ -113,8 +122,9 @@ void packet_in::decrypt()
 		auto pktlen = (encrypted_buffer.size()
 			- crypto_secretbox_NONCEBYTES
 			- crypto_secretbox_MACBYTES);
-		decrypted_buffer.resize(pktlen);
-		if (crypto_secretbox_open_easy(decrypted_buffer.data(),
+		// the ciphertext has to stay intact, the server forwards it as is
+		scratch.resize(pktlen);
+		if (crypto_secretbox_open_easy(scratch.data(),
 				encrypted_buffer.data()
 					+ crypto_secretbox_NONCEBYTES,
 				encrypted_buffer.size()
@@ -122,15 +132,20 @@ void packet_in::decrypt()
 				encrypted_buffer.data(),
 				key.data()))
 			throw packet_exception();
+		read_pos = scratch.data();
+		read_end = scratch.data() + pktlen;
 	} else
 #endif
 	{
 		if (encrypted_buffer.size() < sizeof(packet_type) + 2 * sizeof(plr_t))
 			throw packet_exception();
-		decrypted_buffer = encrypted_buffer;
+		read_pos = encrypted_buffer.data();
+		read_end = encrypted_buffer.data() + encrypted_buffer.size();
 	}
 
 	process_data();
+	read_pos = nullptr;
+	read_end = nullptr;
 
 	have_decrypted = true;
 }
@@ -142,15 +157,25 @@ void packet_out::encrypt()
 	if (have_encrypted)
 		return;
 
+	// allocate once: nonce, cleartext and MAC all fit
+	encrypted_buffer.clear();
+#ifndef NONET
+	encrypted_buffer.reserve(crypto_secretbox_NONCEBYTES + max_header_size
+		+ m_message.size() + m_info.size() + crypto_secretbox_MACBYTES);
+	if (!disable_encryption)
+		encrypted_buffer.resize(crypto_secretbox_NONCEBYTES);
+#else
+	encrypted_buffer.reserve(max_header_size + m_message.size() + m_info.size());
+#endif
+
 	process_data();
 
 #ifndef NONET
 	if (!disable_encryption) {
-		auto len_cleartext = encrypted_buffer.size();
-		encrypted_buffer.insert(encrypted_buffer.begin(),
-			crypto_secretbox_NONCEBYTES, 0);
-		encrypted_buffer.insert(encrypted_buffer.end(),
-			crypto_secretbox_MACBYTES, 0);
+		auto len_cleartext = encrypted_buffer.size()
+			- crypto_secretbox_NONCEBYTES;
+		encrypted_buffer.resize(encrypted_buffer.size()
+			+ crypto_secretbox_MACBYTES);
 		randombytes_buf(encrypted_buffer.data(), crypto_secretbox_NONCEBYTES);
 		if (crypto_secretbox_easy(encrypted_buffer.data()
 					+ crypto_secretbox_NONCEBYTES,
@@ -53,7 +53,6 @@ protected:
 	bool have_encrypted = false;
 	bool have_decrypted = false;
 	buffer_t encrypted_buffer;
-	buffer_t decrypted_buffer;
 
 public:
 	packet(const key_t &k)
@@ -80,13 +79,18 @@ public:
 };
 
 class packet_in : public packet_proc<packet_in> {
+	// cleartext still to be parsed, only valid during decrypt()
+	const unsigned char *read_pos = nullptr;
+	const unsigned char *read_end = nullptr;
+
 public:
 	using packet_proc<packet_in>::packet_proc;
 	void create(buffer_t buf);
+	void reuse(const unsigned char *data, size_t len);
 	void process_element(buffer_t &x);
 	template <class T>
 	void process_element(T &x);
-	void decrypt();
+	void decrypt(buffer_t &scratch);
 };
 
 class packet_out : public packet_proc<packet_out> {
@@ -96,6 +100,9 @@ public:
 	template <packet_type t, typename... Args>
 	void create(Args... args);
 
+	static constexpr size_t max_header_size = sizeof(packet_type) + 2 * sizeof(plr_t)
+		+ sizeof(cookie_t) + sizeof(plr_t) + sizeof(leaveinfo_t);
+
 	void process_element(buffer_t &x);
 	template <class T>
 	void process_element(T &x);
@@ -141,18 +148,17 @@ void packet_proc<P>::process_data()
 
 inline void packet_in::process_element(buffer_t &x)
 {
-	x.insert(x.begin(), decrypted_buffer.begin(), decrypted_buffer.end());
-	decrypted_buffer.resize(0);
+	x.assign(read_pos, read_end);
+	read_pos = read_end;
 }
 
 template <class T>
 void packet_in::process_element(T &x)
 {
-	if (decrypted_buffer.size() < sizeof(T))
+	if (static_cast<size_t>(read_end - read_pos) < sizeof(T))
 		throw packet_exception();
-	std::memcpy(&x, decrypted_buffer.data(), sizeof(T));
-	decrypted_buffer.erase(decrypted_buffer.begin(),
-		decrypted_buffer.begin() + sizeof(T));
+	std::memcpy(&x, read_pos, sizeof(T));
+	read_pos += sizeof(T);
 }
 
 template <>
@@ -190,7 +196,7 @@ inline void packet_out::create<PT_JOIN_REQUEST>(plr_t s, plr_t d,
 	m_src = s;
 	m_dest = d;
 	m_cookie = c;
-	m_info = i;
+	m_info = std::move(i);
 }
 
 template <>
@@ -205,7 +211,7 @@ inline void packet_out::create<PT_JOIN_ACCEPT>(plr_t s, plr_t d, cookie_t c,
 	m_dest = d;
 	m_cookie = c;
 	m_newplr = n;
-	m_info = i;
+	m_info = std::move(i);
 }
 
 template <>
@@ -259,12 +265,17 @@ const unsigned char *packet_out::end(const T &x)
 
 class packet_factory {
 	key_t key = {};
+	// reused for every packet decrypted by this factory
+	buffer_t decrypt_buffer;
+	// handed out by parse_packet, valid until the next call
+	packet_in parsed_packet { key };
 
 public:
 	static constexpr unsigned short max_packet_size = 0xFFFF;
 
 	packet_factory(std::string pw = "");
 	std::unique_ptr<packet> make_packet(buffer_t buf);
+	packet &parse_packet(const unsigned char *data, size_t len);
 	template <packet_type t, typename... Args>
 	std::unique_ptr<packet> make_packet(Args... args);
 };
@@ -273,15 +284,22 @@ inline std::unique_ptr<packet> packet_factory::make_packet(buffer_t buf)
 {
 	std::unique_ptr<packet_in> ret(new packet_in(key));
 	ret->create(std::move(buf));
-	ret->decrypt();
+	ret->decrypt(decrypt_buffer);
 	return std::unique_ptr<packet>(std::move(ret));
 }
 
+inline packet &packet_factory::parse_packet(const unsigned char *data, size_t len)
+{
+	parsed_packet.reuse(data, len);
+	parsed_packet.decrypt(decrypt_buffer);
+	return parsed_packet;
+}
+
 template <packet_type t, typename... Args>
 std::unique_ptr<packet> packet_factory::make_packet(Args... args)
 {
 	std::unique_ptr<packet_out> ret(new packet_out(key));
-	ret->create<t>(args...);
+	ret->create<t>(std::move(args)...);
 	ret->encrypt();
 	return std::unique_ptr<packet>(std::move(ret));
 }
@@ -75,9 +75,7 @@ void tcp_client::handle_recv(const asio::error_code &error, size_t bytes_read)
 	if (bytes_read == 0) {
 		throw std::runtime_error("error: read 0 bytes from server");
 	}
-	recv_buffer.resize(bytes_read);
-	recv_queue.write(std::move(recv_buffer));
-	recv_buffer.resize(frame_queue::max_frame_size);
+	recv_queue.commit(bytes_read);
 	while (recv_queue.packet_ready()) {
 		auto pkt = pktfty->make_packet(recv_queue.read_packet());
 		recv_local(*pkt);
@@ -87,7 +85,7 @@ void tcp_client::handle_recv(const asio::error_code &error, size_t bytes_read)
 
 void tcp_client::start_recv()
 {
-	sock.async_receive(asio::buffer(recv_buffer),
+	sock.async_receive(asio::buffer(recv_queue.write_pos(), recv_queue.write_space()),
 		std::bind(&tcp_client::handle_recv, this,
 			std::placeholders::_1, std::placeholders::_2));
 }
@@ -99,11 +97,9 @@ void tcp_client::handle_send(const asio::error_code &error, size_t bytes_sent)
 
 void tcp_client::send(packet &pkt)
 {
-	const auto *frame = new buffer_t(frame_queue::make_frame(pkt.data()));
-	auto buf = asio::buffer(*frame);
-	asio::async_write(sock, buf, [this, frame](const asio::error_code &error, size_t bytes_sent) {
+	auto frame = frame_queue::make_frame(pkt.data());
+	asio::async_write(sock, frame->buffers(), [this, frame](const asio::error_code &error, size_t bytes_sent) {
 		handle_send(error, bytes_sent);
-		delete frame;
 	});
 }
 
@@ -28,7 +28,6 @@ public:
 
 private:
 	frame_queue recv_queue;
-	buffer_t recv_buffer = buffer_t(frame_queue::max_frame_size);
 
 	asio::io_context ioc;
 	asio::ip::tcp::socket sock = asio::ip::tcp::socket(ioc);
@@ -56,7 +56,8 @@ bool tcp_server::empty()
 
 void tcp_server::start_recv(scc con)
 {
-	con->socket.async_receive(asio::buffer(con->recv_buffer),
+	con->socket.async_receive(asio::buffer(con->recv_queue.write_pos(),
+			con->recv_queue.write_space()),
 		std::bind(&tcp_server::handle_recv, this, con,
 			std::placeholders::_1,
 			std::placeholders::_2));
@@ -69,9 +70,7 @@ void tcp_server::handle_recv(scc con, const asio::error_code &ec,
 		drop_connection(con);
 		return;
 	}
-	con->recv_buffer.resize(bytes_read);
-	con->recv_queue.write(std::move(con->recv_buffer));
-	con->recv_buffer.resize(frame_queue::max_frame_size);
+	con->recv_queue.commit(bytes_read);
 	while (con->recv_queue.packet_ready()) {
 		try {
 			auto pkt = pktfty.make_packet(con->recv_queue.read_packet());
@@ -120,26 +119,30 @@ void tcp_server::handle_recv_packet(packet &pkt)
 
 void tcp_server::send_packet(packet &pkt)
 {
+	// one frame is shared by every connection it is sent to
+	auto frame = frame_queue::make_frame(pkt.data());
 	if (pkt.dest() == PLR_BROADCAST) {
 		for (auto i = 0; i < MAX_PLRS; ++i)
 			if (i != pkt.src() && connections[i])
-				start_send(connections[i], pkt);
+				start_send(connections[i], frame);
 	} else {
 		if (pkt.dest() >= MAX_PLRS)
 			throw server_exception();
 		if ((pkt.dest() != pkt.src()) && connections[pkt.dest()])
-			start_send(connections[pkt.dest()], pkt);
+			start_send(connections[pkt.dest()], frame);
 	}
 }
 
 void tcp_server::start_send(scc con, packet &pkt)
 {
-	const auto *frame = new buffer_t(frame_queue::make_frame(pkt.data()));
-	auto buf = asio::buffer(*frame);
-	asio::async_write(con->socket, buf,
+	start_send(con, frame_queue::make_frame(pkt.data()));
+}
+
+void tcp_server::start_send(scc con, std::shared_ptr<const frame> frame)
+{
+	asio::async_write(con->socket, frame->buffers(),
 		[this, con, frame](const asio::error_code &ec, size_t bytes_sent) {
 			handle_send(con, ec, bytes_sent);
-			delete frame;
 		});
 }
 
@@ -30,7 +30,6 @@ private:
 
 	struct client_connection {
 		frame_queue recv_queue;
-		buffer_t recv_buffer = buffer_t(frame_queue::max_frame_size);
 		plr_t plr = PLR_BROADCAST;
 		asio::ip::tcp::socket socket;
 		asio::steady_timer timer;
@@ -62,6 +61,7 @@ private:
 	void send_connect(scc con);
 	void send_packet(packet &pkt);
 	void start_send(scc con, packet &pkt);
+	void start_send(scc con, std::shared_ptr<const frame> frame);
 	void handle_send(scc con, const asio::error_code &ec, size_t bytes_sent);
 	void start_timeout(scc con);
 	void handle_timeout(scc con, const asio::error_code &ec);
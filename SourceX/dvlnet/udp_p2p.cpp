@@ -84,12 +84,10 @@ void udp_p2p::recv()
 		while (1) { // read until kernel buffer is empty?
 			try {
 				endpoint sender;
-				buffer_t pkt_buf(packet_factory::max_packet_size);
+				recv_buffer.resize(packet_factory::max_packet_size);
 				size_t pkt_len;
-				pkt_len = sock.receive_from(asio::buffer(pkt_buf), sender);
-				pkt_buf.resize(pkt_len);
-				auto pkt = pktfty->make_packet(pkt_buf);
-				recv_decrypted(*pkt, sender);
+				pkt_len = sock.receive_from(asio::buffer(recv_buffer), sender);
+				recv_decrypted(pktfty->parse_packet(recv_buffer.data(), pkt_len), sender);
 			} catch (packet_exception &e) {
 				// drop packet
 			}
@@ -35,6 +35,8 @@ private:
 	std::array<endpoint, MAX_PLRS> nexthop_table;
 
 	asio::ip::udp::socket sock = asio::ip::udp::socket(io_context);
+	// receive_from target, kept at max_packet_size instead of allocating it for every datagram
+	buffer_t recv_buffer;
 
 	void recv();
 	void handle_join_request(packet &pkt, endpoint sender);
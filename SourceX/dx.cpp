@@ -12,6 +12,14 @@
 #include <SDL.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLIT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define BLIT_NEON
+#include <arm_neon.h>
+#endif
+
 namespace dvl {
 
 int sgdwLockCount;
@@ -38,6 +46,210 @@ SDL_Surface *pal_surface;
 
 bool bufferUpdated = false;
 
+/** 8-bit to output pixel lookup, rebuilt when the palette or the output format changes */
+struct PaletteLut {
+	Uint32 format;
+	unsigned int version;
+	Uint32 pixels[256];
+};
+
+/** Lookup for BltFast, keyed by #pal_surface_palette_version */
+static PaletteLut sgBlitLut;
+/** Bounds of what BltFast changed since the last present, empty for all of it */
+static SDL_Rect sgUpdateRect;
+/** Texture the last upload went to, anything else gets the whole surface */
+static SDL_Texture *sgpUploadTexture;
+
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+enum present_frame_state {
+	PFS_FREE,
+	PFS_FILLING,
+	PFS_QUEUED,
+	PFS_PRESENTING,
+};
+
+/** Copy of the screen parts updated during one frame, for the presenter thread */
+struct PresentFrame {
+	/** 8-bit copy of the updated parts, with the palette as of the end of the frame */
+	SDL_Surface *surface;
+	SDL_Rect rects[MAX_PRESENT_RECTS];
+	int nRects;
+	SDL_Color colors[256];
+	unsigned int palVersion;
+	BYTE state;
+	DWORD dwSeq;
+};
+
+/** Protects the frame states and stats below */
+static SDL_mutex *sgpPresentMutex;
+/** Held while the renderer is in use, by the presenter or by the main thread pumping events */
+static SDL_mutex *sgpRenderMutex;
+/** Signalled when a frame is queued or the presenter is to park */
+static SDL_cond *sgpPresentWork;
+/** Signalled when the presenter is done with a frame or has parked */
+static SDL_cond *sgpPresentDone;
+static PresentFrame sgPresentFrames[MAX_PRESENT_FRAMES];
+static int sgnPresentFrames;
+/** Frame BltFast copies into, -1 when the screen is updated directly */
+static int sgnPresentFilling = -1;
+static DWORD sgdwPresentSeq;
+/** The presenter owns the renderer and takes frames */
+static bool sgbPresentActive;
+/** The presenter has let go of the renderer */
+static bool sgbPresentIsParked = true;
+static bool sgbPresentInit;
+static bool sgbPresentThread;
+static SDL_Thread *sgpPresentThread;
+static SDL_threadID sgnPresentThreadId;
+/** The presenter is to exit once parked */
+static bool sgbPresentQuit;
+/** The presenter ran into an SDL error, it parks and leaves the report to the main thread */
+static bool sgbPresentError;
+static char sgszPresentError[256];
+static DWORD sgdwPresentCount;
+static DWORD sgdwPresentBusy;
+static DWORD sgdwPresentDropped;
+static DWORD sgdwPresentLast;
+static DWORD sgdwPresentMaxGap;
+/** Last time the main thread pumped events, it only does so when the renderer is free */
+static DWORD sgdwPumpLast;
+/** Lookup for the presenter, keyed by the palette version of each frame */
+static PaletteLut sgPresentLut;
+
+static int present_handler(void *);
+#endif
+
+static void UnionRect(SDL_Rect *bounds, const SDL_Rect *rect)
+{
+	int right, bottom;
+
+	if (bounds->w == 0) {
+		*bounds = *rect;
+		return;
+	}
+	right = bounds->x + bounds->w;
+	if (rect->x + rect->w > right)
+		right = rect->x + rect->w;
+	bottom = bounds->y + bounds->h;
+	if (rect->y + rect->h > bottom)
+		bottom = rect->y + rect->h;
+	if (rect->x < bounds->x)
+		bounds->x = rect->x;
+	if (rect->y < bounds->y)
+		bounds->y = rect->y;
+	bounds->w = right - bounds->x;
+	bounds->h = bottom - bounds->y;
+}
+
+static void BuildPaletteLut(PaletteLut *lut, const SDL_Color *colors, unsigned int version, SDL_PixelFormat *format)
+{
+	int i;
+
+	if (lut->version == version && lut->format == format->format)
+		return;
+
+	for (i = 0; i < 256; i++)
+		lut->pixels[i] = SDL_MapRGB(format, colors[i].r, colors[i].g, colors[i].b);
+	lut->version = version;
+	lut->format = format->format;
+}
+
+static void ConvertRow32(Uint32 *dst, const BYTE *src, int w, const Uint32 *lut)
+{
+	int i;
+
+#if defined(BLIT_SSE2)
+	for (; w >= 4; w -= 4, dst += 4, src += 4) {
+		_mm_storeu_si128((__m128i *)dst, _mm_set_epi32(lut[src[3]], lut[src[2]], lut[src[1]], lut[src[0]]));
+	}
+#elif defined(BLIT_NEON)
+	for (; w >= 4; w -= 4, dst += 4, src += 4) {
+		vst1q_u32(dst, vcombine_u32(vcreate_u32(lut[src[0]] | (uint64_t)lut[src[1]] << 32), vcreate_u32(lut[src[2]] | (uint64_t)lut[src[3]] << 32)));
+	}
+#endif
+	for (i = 0; i < w; i++)
+		dst[i] = lut[src[i]];
+}
+
+static void ConvertRow16(Uint16 *dst, const BYTE *src, int w, const Uint32 *lut)
+{
+	int i;
+
+#if defined(BLIT_SSE2)
+	for (; w >= 8; w -= 8, dst += 8, src += 8) {
+		_mm_storeu_si128((__m128i *)dst, _mm_set_epi16(lut[src[7]], lut[src[6]], lut[src[5]], lut[src[4]], lut[src[3]], lut[src[2]], lut[src[1]], lut[src[0]]));
+	}
+#elif defined(BLIT_NEON)
+	for (; w >= 4; w -= 4, dst += 4, src += 4) {
+		vst1_u16(dst, vcreate_u16(lut[src[0]] | lut[src[1]] << 16 | (uint64_t)lut[src[2]] << 32 | (uint64_t)lut[src[3]] << 48));
+	}
+#endif
+	for (i = 0; i < w; i++)
+		dst[i] = lut[src[i]];
+}
+
+/**
+ * @brief Convert 8-bit pixels through a palette lookup, into a surface or a locked texture
+ * @return false if the output isn't 16 or 32 bits per pixel
+ */
+static bool ConvertPaletted(const BYTE *src, int srcPitch, BYTE *dst, int dstPitch, int bytesPerPixel, int w, int h, const Uint32 *lut)
+{
+	int i;
+
+	if (bytesPerPixel != 4 && bytesPerPixel != 2)
+		return false;
+
+	for (i = 0; i < h; i++, src += srcPitch, dst += dstPitch) {
+		if (bytesPerPixel == 4)
+			ConvertRow32((Uint32 *)dst, src, w, lut);
+		else
+			ConvertRow16((Uint16 *)dst, src, w, lut);
+	}
+	return true;
+}
+
+/**
+ * @brief Convert part of an 8-bit surface to the output surface, SDL_BlitSurface does the odd formats
+ * @param srcRect Source area, adjusted to the clipped size
+ * @param dstRect Destination area, adjusted to the clipped size
+ * @return False on an SDL error, left for the caller to report
+ */
+static bool BlitPaletted(SDL_Surface *src, SDL_Rect *srcRect, SDL_Surface *dst, SDL_Rect *dstRect, PaletteLut *lut, const SDL_Color *colors, unsigned int version)
+{
+	int w, h;
+	BYTE *s, *d;
+
+	w = srcRect->w;
+	if (dst->w - dstRect->x < w)
+		w = dst->w - dstRect->x;
+	if (src->w - srcRect->x < w)
+		w = src->w - srcRect->x;
+	h = srcRect->h;
+	if (dst->h - dstRect->y < h)
+		h = dst->h - dstRect->y;
+	if (src->h - srcRect->y < h)
+		h = src->h - srcRect->y;
+	dstRect->w = w;
+	dstRect->h = h;
+	if (w <= 0 || h <= 0) {
+		dstRect->w = 0;
+		dstRect->h = 0;
+		return true;
+	}
+	srcRect->w = dstRect->w;
+	srcRect->h = dstRect->h;
+
+	if (!SDL_MUSTLOCK(dst)) {
+		BuildPaletteLut(lut, colors, version, dst->format);
+		s = (BYTE *)src->pixels + srcRect->y * src->pitch + srcRect->x;
+		d = (BYTE *)dst->pixels + dstRect->y * dst->pitch + dstRect->x * dst->format->BytesPerPixel;
+		if (ConvertPaletted(s, src->pitch, d, dst->pitch, dst->format->BytesPerPixel, dstRect->w, dstRect->h, lut->pixels))
+			return true;
+	}
+
+	return SDL_BlitSurface(src, srcRect, dst, dstRect) > -1;
+}
+
 static void dx_create_back_buffer()
 {
 	pal_surface = SDL_CreateRGBSurfaceWithFormat(0, BUFFER_WIDTH, BUFFER_HEIGHT, 8, SDL_PIXELFORMAT_INDEX8);
@@ -52,6 +264,11 @@ static void dx_create_back_buffer()
 	}
 
 	pal_surface_palette_version = 1;
+	// versions start over with the new surface
+	sgBlitLut.version = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	sgPresentLut.version = 0;
+#endif
 }
 
 static void dx_create_primary_surface()
@@ -103,18 +320,22 @@ void lock_buf(BYTE idx)
 
 static void unlock_buf_priv()
 {
+	bool present;
+
 	if (sgdwLockCount == 0)
 		app_fatal("draw main unlock error");
 	if (!gpBuffer)
 		app_fatal("draw consistency error");
 
 	sgdwLockCount--;
-	if (sgdwLockCount == 0) {
+	present = sgdwLockCount == 0;
+	if (present) {
 		gpBufEnd -= (uintptr_t)gpBuffer;
 		//gpBuffer = NULL; unable to return to menu
-		RenderPresent();
 	}
 	sgMemCrit.Leave();
+	if (present)
+		RenderPresent();
 }
 
 void unlock_buf(BYTE idx)
@@ -127,8 +348,54 @@ void unlock_buf(BYTE idx)
 	unlock_buf_priv();
 }
 
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+/**
+ * @brief Stop the presenter thread and free what it used, the next game frame starts it again
+ */
+static void present_cleanup()
+{
+	int i;
+
+	if (sgbPresentThread && SDL_ThreadID() == sgnPresentThreadId)
+		return;
+
+	dx_present_stop();
+	if (sgbPresentThread) {
+		SDL_LockMutex(sgpPresentMutex);
+		sgbPresentQuit = true;
+		SDL_CondSignal(sgpPresentWork);
+		SDL_UnlockMutex(sgpPresentMutex);
+		SDL_WaitThread(sgpPresentThread, NULL);
+		sgpPresentThread = NULL;
+		sgnPresentThreadId = 0;
+		sgbPresentThread = false;
+		sgbPresentQuit = false;
+	}
+
+	SDL_DestroyCond(sgpPresentDone);
+	sgpPresentDone = NULL;
+	SDL_DestroyCond(sgpPresentWork);
+	sgpPresentWork = NULL;
+	SDL_DestroyMutex(sgpRenderMutex);
+	sgpRenderMutex = NULL;
+	SDL_DestroyMutex(sgpPresentMutex);
+	sgpPresentMutex = NULL;
+	for (i = 0; i < sgnPresentFrames; i++) {
+		SDL_FreeSurface(sgPresentFrames[i].surface);
+		sgPresentFrames[i].surface = NULL;
+	}
+	sgnPresentFrames = 0;
+	sgbPresentIsParked = true;
+	sgbPresentError = false;
+	sgbPresentInit = false;
+}
+#endif
+
 void dx_cleanup()
 {
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	present_cleanup();
+#endif
 	if (ghMainWnd)
 		SDL_HideWindow(window);
 	sgMemCrit.Enter();
@@ -180,6 +447,321 @@ void CreatePalette()
 	}
 }
 
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+/**
+ * @brief Let go of the OpenGL context so the renderer can be used from another thread
+ */
+static void present_release_context()
+{
+	if (SDL_GetWindowFlags(window) & SDL_WINDOW_OPENGL)
+		SDL_GL_MakeCurrent(window, NULL);
+}
+
+/**
+ * @brief Read the "Present Frames" setting and start the presenter thread
+ */
+static void dx_present_init()
+{
+	int value;
+
+	sgbPresentInit = true;
+#if defined(VITA) || defined(__APPLE__)
+	// the renderer has to stay on the main thread there
+	return;
+#endif
+	value = MAX_PRESENT_FRAMES;
+	if (!SRegLoadValue("devilutionx", "Present Frames", 0, &value))
+		SRegSaveValue("devilutionx", "Present Frames", 0, value);
+	// fewer than two frames means presenting on the main thread
+	if (value < 2 || renderer == NULL)
+		return;
+	if (value > MAX_PRESENT_FRAMES)
+		value = MAX_PRESENT_FRAMES;
+	sgnPresentFrames = value;
+
+	sgpPresentMutex = SDL_CreateMutex();
+	sgpRenderMutex = SDL_CreateMutex();
+	sgpPresentWork = SDL_CreateCond();
+	sgpPresentDone = SDL_CreateCond();
+	if (sgpPresentMutex == NULL || sgpRenderMutex == NULL || sgpPresentWork == NULL || sgpPresentDone == NULL) {
+		ErrSdl();
+	}
+	sgpPresentThread = SDL_CreateThread(present_handler, "present", NULL);
+	if (sgpPresentThread == NULL) {
+		ErrSdl();
+	}
+	sgnPresentThreadId = SDL_GetThreadID(sgpPresentThread);
+	sgbPresentThread = true;
+}
+
+/**
+ * @brief Give a frame the current palette, only copied when it changed
+ */
+static void present_set_palette(PresentFrame *frame)
+{
+	if (frame->palVersion == pal_surface_palette_version)
+		return;
+
+	memcpy(frame->colors, palette->colors, sizeof(frame->colors));
+	if (SDL_SetPaletteColors(frame->surface->format->palette, frame->colors, 0, 256) <= -1) {
+		ErrSdl();
+	}
+	frame->palVersion = pal_surface_palette_version;
+}
+
+/**
+ * @brief Convert the updated parts of a frame to the renderer texture surface
+ * @param bounds Receives the area that changed
+ * @return False on an SDL error
+ */
+static bool present_convert(PresentFrame *frame, SDL_Rect *bounds)
+{
+	int i;
+	SDL_Rect src, dst;
+
+	for (i = 0; i < frame->nRects; i++) {
+		src = frame->rects[i];
+		dst = src;
+		if (!BlitPaletted(frame->surface, &src, renderer_texture_surface, &dst, &sgPresentLut, frame->colors, frame->palVersion)) {
+			frame->nRects = 0;
+			return false;
+		}
+		if (dst.w != 0)
+			UnionRect(bounds, &dst);
+	}
+	frame->nRects = 0;
+	return true;
+}
+
+/**
+ * @brief Show the SDL error the presenter thread ran into, it can't bring up the dialog itself
+ */
+static void present_check_error()
+{
+	bool error;
+
+	SDL_LockMutex(sgpPresentMutex);
+	error = sgbPresentError;
+	SDL_UnlockMutex(sgpPresentMutex);
+	if (!error)
+		return;
+
+	dx_present_stop();
+	ErrDlg("SDL Error", sgszPresentError, __FILE__, __LINE__);
+}
+
+/**
+ * @brief Hand the frame being filled to the presenter thread
+ */
+static void present_queue_frame()
+{
+	PresentFrame *frame;
+
+	frame = &sgPresentFrames[sgnPresentFilling];
+	present_set_palette(frame);
+
+	SDL_LockMutex(sgpPresentMutex);
+	frame->state = PFS_QUEUED;
+	frame->dwSeq = ++sgdwPresentSeq;
+	SDL_CondSignal(sgpPresentWork);
+	SDL_UnlockMutex(sgpPresentMutex);
+}
+
+/**
+ * @brief Pick the frame BltFast copies into next
+ *
+ * Takes a free frame. When the presenter is behind the newest queued frame is
+ * filled further instead, dropping it rather than holding up the game.
+ * @param bWait Wait for a free frame instead
+ */
+static void present_next_frame(bool bWait)
+{
+	int i, newest;
+
+	SDL_LockMutex(sgpPresentMutex);
+	while (true) {
+		newest = -1;
+		for (i = 0; i < sgnPresentFrames; i++) {
+			if (sgPresentFrames[i].state == PFS_FREE)
+				break;
+			if (sgPresentFrames[i].state == PFS_QUEUED && (newest == -1 || sgPresentFrames[i].dwSeq > sgPresentFrames[newest].dwSeq))
+				newest = i;
+		}
+		if (i < sgnPresentFrames)
+			break;
+		if (newest != -1 && !bWait) {
+			i = newest;
+			sgdwPresentDropped++;
+			break;
+		}
+		SDL_CondWait(sgpPresentDone, sgpPresentMutex);
+	}
+	sgPresentFrames[i].state = PFS_FILLING;
+	sgnPresentFilling = i;
+	SDL_UnlockMutex(sgpPresentMutex);
+}
+
+/**
+ * @brief Copy part of the back buffer into the frame being filled
+ */
+static void present_copy(SDL_Rect *src, SDL_Rect *dst)
+{
+	int i;
+	BYTE *s, *d;
+	PresentFrame *frame;
+
+	frame = &sgPresentFrames[sgnPresentFilling];
+	if (frame->nRects == MAX_PRESENT_RECTS) {
+		// send what there is, the rest of the frame follows in the next one
+		present_queue_frame();
+		present_next_frame(true);
+		frame = &sgPresentFrames[sgnPresentFilling];
+	}
+
+	if (dst->x + dst->w > frame->surface->w)
+		dst->w = frame->surface->w - dst->x;
+	if (dst->y + dst->h > frame->surface->h)
+		dst->h = frame->surface->h - dst->y;
+	if (dst->w <= 0 || dst->h <= 0)
+		return;
+
+	s = (BYTE *)pal_surface->pixels + src->y * pal_surface->pitch + src->x;
+	d = (BYTE *)frame->surface->pixels + dst->y * frame->surface->pitch + dst->x;
+	for (i = 0; i < dst->h; i++, s += pal_surface->pitch, d += frame->surface->pitch)
+		memcpy(d, s, dst->w);
+	frame->rects[frame->nRects++] = *dst;
+}
+#endif
+
+/**
+ * @brief Let the presenter thread take over the renderer, called before each game frame
+ */
+void dx_present_start()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	int i;
+
+	if (!sgbPresentInit)
+		dx_present_init();
+	if (!sgbPresentThread)
+		return;
+	present_check_error();
+	if (sgnPresentFilling != -1)
+		return;
+
+	for (i = 0; i < sgnPresentFrames; i++) {
+		if (sgPresentFrames[i].surface == NULL) {
+			sgPresentFrames[i].surface = SDL_CreateRGBSurfaceWithFormat(0, renderer_texture_surface->w, renderer_texture_surface->h, 8, SDL_PIXELFORMAT_INDEX8);
+			if (sgPresentFrames[i].surface == NULL) {
+				ErrSdl();
+			}
+		}
+		sgPresentFrames[i].state = PFS_FREE;
+		sgPresentFrames[i].nRects = 0;
+		sgPresentFrames[i].palVersion = 0;
+	}
+
+	// show what was converted here before giving up the renderer
+	RenderPresent();
+	present_release_context();
+
+	SDL_LockMutex(sgpPresentMutex);
+	sgbPresentActive = true;
+	sgbPresentIsParked = false;
+	sgdwPresentLast = 0;
+	SDL_UnlockMutex(sgpPresentMutex);
+	sgPresentFrames[0].state = PFS_FILLING;
+	sgnPresentFilling = 0;
+#endif
+}
+
+/**
+ * @brief Wait for the presenter thread to show all queued frames and give the renderer back
+ *
+ * Needed before anything else touches the renderer: menus, movies and cleanup.
+ */
+void dx_present_stop()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	PresentFrame *frame;
+
+	if (sgnPresentFilling == -1 || SDL_ThreadID() == sgnPresentThreadId)
+		return;
+
+	frame = &sgPresentFrames[sgnPresentFilling];
+	sgnPresentFilling = -1;
+	SDL_LockMutex(sgpPresentMutex);
+	sgbPresentActive = false;
+	SDL_CondSignal(sgpPresentWork);
+	while (!sgbPresentIsParked)
+		SDL_CondWait(sgpPresentDone, sgpPresentMutex);
+	SDL_UnlockMutex(sgpPresentMutex);
+
+	// updates since the last present go out with the next one from here
+	if (frame->nRects != 0) {
+		present_set_palette(frame);
+		if (!present_convert(frame, &sgUpdateRect)) {
+			ErrSdl();
+		}
+		bufferUpdated = true;
+	}
+	frame->state = PFS_FREE;
+#endif
+}
+
+/**
+ * @brief Frame pacing of the presenter thread, all zero when presenting on the main thread
+ * @param frames Receives the number of frames shown
+ * @param busyTicks Receives the total time spent converting, uploading and presenting
+ * @param dropped Receives the number of frames replaced by a newer one before being shown
+ * @param maxGap Receives the longest time between two presents since the last call
+ */
+void GetPresentStats(DWORD *frames, DWORD *busyTicks, DWORD *dropped, DWORD *maxGap)
+{
+	*frames = 0;
+	*busyTicks = 0;
+	*dropped = 0;
+	*maxGap = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	if (!sgbPresentThread)
+		return;
+
+	SDL_LockMutex(sgpPresentMutex);
+	*frames = sgdwPresentCount;
+	*busyTicks = sgdwPresentBusy;
+	*dropped = sgdwPresentDropped;
+	*maxGap = sgdwPresentMaxGap;
+	sgdwPresentMaxGap = 0;
+	SDL_UnlockMutex(sgpPresentMutex);
+#endif
+}
+
+bool PresentPollEvent(SDL_Event *event)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	bool result;
+	DWORD tc;
+
+	if (sgnPresentFilling != -1) {
+		// window events reach the renderer while pumping, only wait for the presenter when it's been a while
+		tc = SDL_GetTicks();
+		if (SDL_TryLockMutex(sgpRenderMutex) != 0) {
+			if (tc - sgdwPumpLast < 50) {
+				if (event == NULL)
+					return SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT) != SDL_FALSE;
+				return SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) > 0;
+			}
+			SDL_LockMutex(sgpRenderMutex);
+		}
+		sgdwPumpLast = tc;
+		result = SDL_PollEvent(event) != 0;
+		SDL_UnlockMutex(sgpRenderMutex);
+		return result;
+	}
+#endif
+	return SDL_PollEvent(event) != 0;
+}
+
 void BltFast(DWORD dwX, DWORD dwY, LPRECT lpSrcRect)
 {
 	auto w = static_cast<decltype(SDL_Rect().w)>(lpSrcRect->right - lpSrcRect->left + 1);
@@ -195,14 +777,128 @@ void BltFast(DWORD dwX, DWORD dwY, LPRECT lpSrcRect)
 		w, h
 	};
 
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	if (sgnPresentFilling != -1) {
+		present_copy(&src_rect, &dst_rect);
+		bufferUpdated = true;
+		return;
+	}
+#endif
+
 	// Convert from 8-bit to 32-bit
-	if (SDL_BlitSurface(pal_surface, &src_rect, GetOutputSurface(), &dst_rect) <= -1) {
+	if (!BlitPaletted(pal_surface, &src_rect, GetOutputSurface(), &dst_rect, &sgBlitLut, palette->colors, pal_surface_palette_version)) {
 		ErrSdl();
 	}
+	if (dst_rect.w != 0)
+		UnionRect(&sgUpdateRect, &dst_rect);
 
 	bufferUpdated = true;
 }
 
+#ifndef USE_SDL1
+/**
+ * @brief Upload the renderer texture surface and show it
+ * @param bounds Part of the surface that changed, empty for all of it
+ * @return False on an SDL error, left for the caller to report as this also runs on the presenter thread
+ */
+static bool RenderPresentTexture(SDL_Surface *surface, const SDL_Rect *bounds)
+{
+	BYTE *pixels;
+
+	if (bounds->w != 0 && texture == sgpUploadTexture) {
+		pixels = (BYTE *)surface->pixels + bounds->y * surface->pitch + bounds->x * surface->format->BytesPerPixel;
+		if (SDL_UpdateTexture(texture, bounds, pixels, surface->pitch) <= -1) {
+			return false;
+		}
+	} else {
+		if (SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch) <= -1) { //pitch is 2560
+			return false;
+		}
+		sgpUploadTexture = texture;
+	}
+
+	// Clear buffer to avoid artifacts in case the window was resized
+	if (SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255) <= -1) { // TODO only do this if window was resized
+		return false;
+	}
+
+	if (SDL_RenderClear(renderer) <= -1) {
+		return false;
+	}
+
+	if (SDL_RenderCopy(renderer, texture, NULL, NULL) <= -1) {
+		return false;
+	}
+	SDL_RenderPresent(renderer);
+	return true;
+}
+#endif
+
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+static int present_handler(void *)
+{
+	int i, next;
+	bool ok;
+	DWORD start, tc;
+	PresentFrame *frame;
+	SDL_Rect bounds;
+
+	SDL_LockMutex(sgpPresentMutex);
+	while (true) {
+		next = -1;
+		for (i = 0; i < sgnPresentFrames; i++) {
+			if (sgPresentFrames[i].state == PFS_QUEUED && (next == -1 || sgPresentFrames[i].dwSeq < sgPresentFrames[next].dwSeq))
+				next = i;
+		}
+		if (next != -1 && sgbPresentError) {
+			// nothing is shown after an error, keep the main thread from waiting on a free frame
+			sgPresentFrames[next].state = PFS_FREE;
+			SDL_CondSignal(sgpPresentDone);
+			continue;
+		}
+		if (next == -1) {
+			if ((!sgbPresentActive || sgbPresentError) && !sgbPresentIsParked) {
+				present_release_context();
+				sgbPresentIsParked = true;
+				SDL_CondSignal(sgpPresentDone);
+			}
+			if (sgbPresentQuit)
+				break;
+			SDL_CondWait(sgpPresentWork, sgpPresentMutex);
+			continue;
+		}
+		frame = &sgPresentFrames[next];
+		frame->state = PFS_PRESENTING;
+		SDL_UnlockMutex(sgpPresentMutex);
+
+		start = SDL_GetTicks();
+		SDL_LockMutex(sgpRenderMutex);
+		bounds.w = 0;
+		ok = present_convert(frame, &bounds) && RenderPresentTexture(renderer_texture_surface, &bounds);
+		if (!ok) {
+			// the error text is kept per thread
+			SDL_strlcpy(sgszPresentError, SDL_GetError(), sizeof(sgszPresentError));
+		}
+		SDL_UnlockMutex(sgpRenderMutex);
+		tc = SDL_GetTicks();
+
+		SDL_LockMutex(sgpPresentMutex);
+		frame->state = PFS_FREE;
+		if (!ok)
+			sgbPresentError = true;
+		sgdwPresentCount++;
+		sgdwPresentBusy += tc - start;
+		if (sgdwPresentLast != 0 && tc - sgdwPresentLast > sgdwPresentMaxGap)
+			sgdwPresentMaxGap = tc - sgdwPresentLast;
+		sgdwPresentLast = tc;
+		SDL_CondSignal(sgpPresentDone);
+	}
+	SDL_UnlockMutex(sgpPresentMutex);
+
+	return 0;
+}
+#endif
+
 void RenderPresent()
 {
 	SDL_Surface *surface = GetOutputSurface();
@@ -214,29 +910,27 @@ void RenderPresent()
 		return;
 	}
 
+	profile_begin(PROF_PRESENT);
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+	if (sgnPresentFilling != -1) {
+		present_check_error();
+		present_queue_frame();
+		present_next_frame(false);
+		bufferUpdated = false;
+		profile_end(PROF_PRESENT);
+		return;
+	}
+#endif
+
 #ifdef USE_SDL1
 	if (SDL_Flip(surface) <= -1) {
 		ErrSdl();
 	}
 #else
 	if (renderer) {
-		if (SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch) <= -1) { //pitch is 2560
-			ErrSdl();
-		}
-
-		// Clear buffer to avoid artifacts in case the window was resized
-		if (SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255) <= -1) { // TODO only do this if window was resized
-			ErrSdl();
-		}
-
-		if (SDL_RenderClear(renderer) <= -1) {
-			ErrSdl();
-		}
-
-		if (SDL_RenderCopy(renderer, texture, NULL, NULL) <= -1) {
+		if (!RenderPresentTexture(surface, &sgUpdateRect)) {
 			ErrSdl();
 		}
-		SDL_RenderPresent(renderer);
 	} else {
 		if (SDL_UpdateWindowSurface(window) <= -1) {
 			ErrSdl();
@@ -245,6 +939,8 @@ void RenderPresent()
 #endif
 
 	bufferUpdated = false;
+	sgUpdateRect.w = 0;
+	profile_end(PROF_PRESENT);
 }
 
 void PaletteGetEntries(DWORD dwNumEntries, LPPALETTEENTRY lpEntries)
@@ -25,4 +25,7 @@ extern bool bufferUpdated;
 // SDL2, upscale: Renderer texture surface.
 SDL_Surface *GetOutputSurface();
 
+// SDL_PollEvent that stays clear of the renderer while the presenter thread uses it.
+bool PresentPollEvent(SDL_Event *event);
+
 } // namespace dvl
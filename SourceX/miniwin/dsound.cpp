@@ -54,14 +54,12 @@ void DirectSoundBuffer::Stop()
 	}
 };
 
-int DirectSoundBuffer::SetChunk(BYTE *fileData, DWORD dwBytes)
+/**
+ * @brief Play samples already in the mixer's format, they are not copied and have to outlive the buffer
+ */
+int DirectSoundBuffer::SetSamples(BYTE *pcmData, DWORD dwBytes)
 {
-	SDL_RWops *buf1 = SDL_RWFromConstMem(fileData, dwBytes);
-	if (buf1 == NULL) {
-		return -1;
-	}
-
-	chunk = Mix_LoadWAV_RW(buf1, 1);
+	chunk = Mix_QuickLoad_RAW(pcmData, dwBytes);
 	if (chunk == NULL) {
 		return -1;
 	}
@@ -18,7 +18,7 @@ public:
 	void GetStatus(LPDWORD pdwStatus) override;
 	void Play(int lVolume, int lPan) override;
 	void Stop() override;
-	int SetChunk(BYTE *fileData, DWORD dwBytes) override;
+	int SetSamples(BYTE *pcmData, DWORD dwBytes) override;
 
 private:
 	Mix_Chunk *chunk;
@@ -1,25 +1,31 @@
 #include <cstdio>
 #include <set>
 #include <string>
-#include <iterator>
-#include <vector>
-#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <stdexcept>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "devilution.h"
 #include "stubs.h"
+#include "../../3rdParty/Storm/Source/storm.h"
 
 namespace dvl {
 
-struct memfile {
+// reads and writes go straight to the file at the current position, so a
+// save only touches the blocks mpqapi changes instead of the whole archive
+struct diskfile {
 	std::string path;
-	std::vector<char> buf;
-	std::size_t pos = 0;
+	FILE *fp = nullptr;
 };
 
-static std::set<memfile *> files;
+static std::set<diskfile *> files;
+// save archives are written from the save thread while the game closes events
+static CCritSect files_crit;
 
 HANDLE CreateFileA(LPCSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode,
     LPSECURITY_ATTRIBUTES lpSecurityAttributes, DWORD dwCreationDisposition,
@@ -29,81 +35,108 @@ HANDLE CreateFileA(LPCSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode,
 	TranslateFileName(name, sizeof(name), lpFileName);
 	DUMMY_PRINT("file: %s (%s)", lpFileName, name);
 	UNIMPLEMENTED_UNLESS(!(dwDesiredAccess & ~(DVL_GENERIC_READ | DVL_GENERIC_WRITE)));
-	memfile *file = new memfile;
-	file->path = name;
+	const char *mode;
 	if (dwCreationDisposition == DVL_OPEN_EXISTING) {
-		// read contents of existing file into buffer
-		std::ifstream filestream(file->path, std::ios::binary);
-		if (!filestream.fail()) {
-			file->buf.insert(file->buf.begin(),
-			    std::istreambuf_iterator<char>(filestream),
-			    std::istreambuf_iterator<char>());
-		}
+		mode = (dwDesiredAccess & DVL_GENERIC_WRITE) ? "r+b" : "rb";
 	} else if (dwCreationDisposition == DVL_CREATE_ALWAYS) {
-		// start with empty file
+		mode = "w+b";
 	} else {
 		UNIMPLEMENTED();
 	}
+	FILE *fp = std::fopen(name, mode);
+	if (fp == nullptr) {
+		SetLastError(DVL_ERROR_FILE_NOT_FOUND);
+		return (HANDLE)-1;
+	}
+	diskfile *file = new diskfile;
+	file->path = name;
+	file->fp = fp;
+	files_crit.Enter();
 	files.insert(file);
+	files_crit.Leave();
 	return file;
 }
 
 WINBOOL ReadFile(HANDLE hFile, LPVOID lpBuffer, DWORD nNumberOfBytesToRead, LPDWORD lpNumberOfBytesRead,
     LPOVERLAPPED lpOverlapped)
 {
-	memfile *file = static_cast<memfile *>(hFile);
+	diskfile *file = static_cast<diskfile *>(hFile);
 	UNIMPLEMENTED_UNLESS(!lpOverlapped);
-	size_t len = std::min<size_t>(file->buf.size() - file->pos, nNumberOfBytesToRead);
-	std::copy(file->buf.begin() + file->pos, file->buf.begin() + file->pos + len, static_cast<char *>(lpBuffer));
-	file->pos += len;
+	// switching from writing to reading needs a seek in between
+	std::fseek(file->fp, 0, SEEK_CUR);
+	size_t len = std::fread(lpBuffer, 1, nNumberOfBytesToRead, file->fp);
 	*lpNumberOfBytesRead = len;
-	return true;
+	return !std::ferror(file->fp);
 }
 
 DWORD GetFileSize(HANDLE hFile, LPDWORD lpFileSizeHigh)
 {
-	memfile *file = static_cast<memfile *>(hFile);
-	return file->buf.size();
+	diskfile *file = static_cast<diskfile *>(hFile);
+	long pos = std::ftell(file->fp);
+	if (pos == -1 || std::fseek(file->fp, 0, SEEK_END))
+		return (DWORD)-1;
+	long size = std::ftell(file->fp);
+	std::fseek(file->fp, pos, SEEK_SET);
+	return size;
 }
 
 WINBOOL WriteFile(HANDLE hFile, LPCVOID lpBuffer, DWORD nNumberOfBytesToWrite,
     LPDWORD lpNumberOfBytesWritten, LPOVERLAPPED lpOverlapped)
 {
-	memfile *file = static_cast<memfile *>(hFile);
+	diskfile *file = static_cast<diskfile *>(hFile);
 	UNIMPLEMENTED_UNLESS(!lpOverlapped);
+	*lpNumberOfBytesWritten = 0;
 	if (!nNumberOfBytesToWrite)
 		return true;
-	if (file->buf.size() < file->pos + nNumberOfBytesToWrite)
-		file->buf.resize(file->pos + nNumberOfBytesToWrite);
-	std::copy(static_cast<const char *>(lpBuffer),
-	    static_cast<const char *>(lpBuffer) + nNumberOfBytesToWrite,
-	    file->buf.begin() + file->pos);
-	file->pos += nNumberOfBytesToWrite;
-	*lpNumberOfBytesWritten = nNumberOfBytesToWrite;
-	return true;
+	std::fseek(file->fp, 0, SEEK_CUR);
+	size_t len = std::fwrite(lpBuffer, 1, nNumberOfBytesToWrite, file->fp);
+	*lpNumberOfBytesWritten = len;
+	return len == nNumberOfBytesToWrite;
 }
 
 DWORD SetFilePointer(HANDLE hFile, LONG lDistanceToMove, PLONG lpDistanceToMoveHigh, DWORD dwMoveMethod)
 {
-	memfile *file = static_cast<memfile *>(hFile);
+	diskfile *file = static_cast<diskfile *>(hFile);
 	UNIMPLEMENTED_UNLESS(!lpDistanceToMoveHigh);
+	int whence;
 	if (dwMoveMethod == DVL_FILE_BEGIN) {
-		file->pos = lDistanceToMove;
+		whence = SEEK_SET;
 	} else if (dwMoveMethod == DVL_FILE_CURRENT) {
-		file->pos += lDistanceToMove;
+		whence = SEEK_CUR;
 	} else {
 		UNIMPLEMENTED();
 	}
-	if (file->buf.size() < file->pos + 1)
-		file->buf.resize(file->pos + 1);
-	return file->pos;
+	if (std::fseek(file->fp, lDistanceToMove, whence))
+		return (DWORD)-1;
+	return std::ftell(file->fp);
 }
 
 WINBOOL SetEndOfFile(HANDLE hFile)
 {
-	memfile *file = static_cast<memfile *>(hFile);
-	file->buf.erase(file->buf.begin() + file->pos, file->buf.end());
-	return true;
+	diskfile *file = static_cast<diskfile *>(hFile);
+	long pos = std::ftell(file->fp);
+	if (pos == -1 || std::fflush(file->fp))
+		return false;
+#ifdef _WIN32
+	return _chsize(_fileno(file->fp), pos) == 0;
+#else
+	return ftruncate(fileno(file->fp), pos) == 0;
+#endif
+}
+
+/**
+ * @brief Push everything written so far through to the disk
+ */
+WINBOOL FlushFileBuffers(HANDLE hFile)
+{
+	diskfile *file = static_cast<diskfile *>(hFile);
+	if (std::fflush(file->fp))
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file->fp)) == 0;
+#else
+	return fsync(fileno(file->fp)) == 0;
+#endif
 }
 
 DWORD GetFileAttributesA(LPCSTR lpFileName)
@@ -123,37 +156,17 @@ WINBOOL SetFileAttributesA(LPCSTR lpFileName, DWORD dwFileAttributes)
 	return true;
 }
 
-void ShowOutOfDiskError()
-{
-	char *text = "Failed to save, please free some disk space and try again.";
-	UiErrorOkDialog("Out of Disk Space", text);
-}
-
 WINBOOL CloseHandle(HANDLE hObject)
 {
-	memfile *file = static_cast<memfile *>(hObject);
-	if (files.find(file) == files.end())
+	diskfile *file = static_cast<diskfile *>(hObject);
+	files_crit.Enter();
+	bool found = files.erase(file) != 0;
+	files_crit.Leave();
+	if (!found)
 		return CloseEvent(hObject);
-	std::unique_ptr<memfile> ufile(file); // ensure that delete file is
-	                                      // called on returning
-	files.erase(file);
-	std::ofstream filestream(file->path + ".tmp", std::ios::binary | std::ios::trunc);
-	if (filestream.fail()) {
-		ShowOutOfDiskError();
-		return false;
-	}
-	filestream.write(file->buf.data(), file->buf.size());
-	if (filestream.fail()) {
-		ShowOutOfDiskError();
-		return false;
-	}
-	filestream.close();
-	std::remove(file->path.c_str());
-	if (std::rename((file->path + ".tmp").c_str(), file->path.c_str())) {
-		ShowOutOfDiskError();
-		return false;
-	}
-	return true;
+	std::unique_ptr<diskfile> ufile(file); // ensure that delete file is
+	                                       // called on returning
+	return std::fclose(file->fp) == 0;
 }
 
 } // namespace dvl
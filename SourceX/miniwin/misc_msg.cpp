@@ -12,6 +12,7 @@
 #endif
 
 #include "devilution.h"
+#include "miniwin/ddraw.h"
 #include "stubs.h"
 
 /** @file
@@ -313,7 +314,7 @@ WINBOOL PeekMessageA(LPMSG lpMsg, HWND hWnd, UINT wMsgFilterMin, UINT wMsgFilter
 	if (wRemoveMsg == DVL_PM_NOREMOVE) {
 		// This does not actually fill out lpMsg, but this is ok
 		// since the engine never uses it in this case
-		return !message_queue.empty() || SDL_PollEvent(NULL);
+		return !message_queue.empty() || PresentPollEvent(NULL);
 	}
 	if (wRemoveMsg != DVL_PM_REMOVE) {
 		UNIMPLEMENTED();
@@ -327,7 +328,7 @@ WINBOOL PeekMessageA(LPMSG lpMsg, HWND hWnd, UINT wMsgFilterMin, UINT wMsgFilter
 
 	SDL_Event e;
 
-	if (!SDL_PollEvent(&e)) {
+	if (!PresentPollEvent(&e)) {
 		return false;
 	}
 
@@ -25,6 +25,22 @@ Mix_Music *music;
 SDL_RWops *musicRw;
 char *musicBuffer;
 
+/** Decoded samples of a sound file, shared by every TSnd loaded from it */
+struct SoundCacheEntry {
+	SoundCacheEntry *next;
+	char path[MAX_PATH];
+	Mix_Chunk *chunk;
+	int refs;
+	DWORD lastUse;
+};
+
+/** Every decoded sound, the unreferenced ones are kept until they exceed sgdwSoundCacheBudget */
+static SoundCacheEntry *sgpSoundCache;
+static DWORD sgdwSoundCacheBudget;
+static DWORD sgdwSoundCacheIdle;
+static DWORD sgdwSoundCacheClock;
+static BOOLEAN sgbSoundCacheInit;
+
 /* data */
 
 BOOLEAN gbMusicOn = true;
@@ -90,28 +106,130 @@ void snd_play_snd(TSnd *pSnd, int lVolume, int lPan)
 	pSnd->start_tc = tc;
 }
 
-TSnd *sound_file_load(char *path)
+static SoundCacheEntry *sound_cache_find(const char *path)
+{
+	SoundCacheEntry *entry;
+
+	for (entry = sgpSoundCache; entry != NULL; entry = entry->next) {
+		if (_strcmpi(entry->path, path) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Free the least recently used unreferenced sounds until they fit in the budget
+ */
+static void sound_cache_trim()
+{
+	SoundCacheEntry **prev, **oldest, *entry;
+
+	while (sgdwSoundCacheIdle > sgdwSoundCacheBudget) {
+		oldest = NULL;
+		for (prev = &sgpSoundCache; *prev != NULL; prev = &(*prev)->next) {
+			if ((*prev)->refs == 0 && (oldest == NULL || (*prev)->lastUse < (*oldest)->lastUse))
+				oldest = prev;
+		}
+		if (oldest == NULL)
+			break;
+		entry = *oldest;
+		*oldest = entry->next;
+		sgdwSoundCacheIdle -= entry->chunk->alen;
+		Mix_FreeChunk(entry->chunk);
+		delete entry;
+	}
+}
+
+/**
+ * @brief Get the decoded samples of a sound file, decoding it only if it isn't cached
+ *
+ * The budget comes from the "Sound Cache Size" setting in kilobytes, it only
+ * counts sounds nothing uses right now, such as the monster sounds of the last level.
+ */
+static SoundCacheEntry *sound_cache_load(const char *path)
 {
+	SoundCacheEntry *entry;
 	HANDLE file;
 	BYTE *wave_file;
-	TSnd *pSnd;
 	DWORD dwBytes;
-	int error;
+	SDL_RWops *rw;
+	Mix_Chunk *chunk;
+	int value;
+
+	if (!sgbSoundCacheInit) {
+		sgbSoundCacheInit = true;
+		value = 8192;
+		if (!SRegLoadValue("devilutionx", "Sound Cache Size", 0, &value))
+			SRegSaveValue("devilutionx", "Sound Cache Size", 0, value);
+		sgdwSoundCacheBudget = value > 0 ? value * 1024 : 0;
+	}
+
+	entry = sound_cache_find(path);
+	if (entry != NULL) {
+		if (entry->refs == 0)
+			sgdwSoundCacheIdle -= entry->chunk->alen;
+		entry->refs++;
+		entry->lastUse = ++sgdwSoundCacheClock;
+		return entry;
+	}
 
 	WOpenFile(path, &file, false);
+	dwBytes = SFileGetFileSize(file, NULL);
+	wave_file = DiabloAllocPtr(dwBytes);
+	SFileReadFile(file, wave_file, dwBytes, NULL, NULL);
+	WCloseFile(file);
+
+	chunk = NULL;
+	rw = SDL_RWFromConstMem(wave_file, dwBytes);
+	if (rw != NULL)
+		chunk = Mix_LoadWAV_RW(rw, 1);
+	mem_free_dbg(wave_file);
+	if (chunk == NULL) {
+		ErrSdl();
+	}
+
+	entry = new SoundCacheEntry;
+	SStrCopy(entry->path, path, MAX_PATH);
+	entry->chunk = chunk;
+	entry->refs = 1;
+	entry->lastUse = ++sgdwSoundCacheClock;
+	entry->next = sgpSoundCache;
+	sgpSoundCache = entry;
+
+	return entry;
+}
+
+static void sound_cache_release(const char *path)
+{
+	SoundCacheEntry *entry;
+
+	entry = sound_cache_find(path);
+	if (entry == NULL || entry->refs == 0)
+		return;
+
+	entry->refs--;
+	if (entry->refs == 0) {
+		sgdwSoundCacheIdle += entry->chunk->alen;
+		sound_cache_trim();
+	}
+}
+
+TSnd *sound_file_load(char *path)
+{
+	SoundCacheEntry *entry;
+	TSnd *pSnd;
+	int error;
+
+	entry = sound_cache_load(path);
 	pSnd = (TSnd *)DiabloAllocPtr(sizeof(TSnd));
 	memset(pSnd, 0, sizeof(TSnd));
 	pSnd->sound_path = path;
 	pSnd->start_tc = GetTickCount() - 81;
 
-	dwBytes = SFileGetFileSize(file, NULL);
-	wave_file = DiabloAllocPtr(dwBytes);
-	SFileReadFile(file, wave_file, dwBytes, NULL, NULL);
-
+	// each TSnd gets its own chunk over the shared samples, so it is told apart on the channels
 	pSnd->DSB = new DirectSoundBuffer();
-	error = pSnd->DSB->SetChunk(wave_file, dwBytes);
-	WCloseFile(file);
-	mem_free_dbg(wave_file);
+	error = pSnd->DSB->SetSamples(entry->chunk->abuf, entry->chunk->alen);
 	if (error != 0) {
 		ErrSdl();
 	}
@@ -127,6 +245,7 @@ void sound_file_cleanup(TSnd *sound_file)
 			sound_file->DSB->Release();
 			delete static_cast<DirectSoundBuffer *>(sound_file->DSB);
 			sound_file->DSB = NULL;
+			sound_cache_release(sound_file->sound_path);
 		}
 
 		mem_free_dbg(sound_file);
@@ -183,16 +302,99 @@ void sound_store_volume(char *key, int value)
 	SRegSaveValue("Diablo", key, 0, value);
 }
 
+#ifndef VITA
+/*
+ * Music tracks are several megabytes each, SDL_mixer reads them from the
+ * archive a piece at a time on the audio thread through these.
+ */
+
+#ifdef USE_SDL1
+static int music_rw_seek(SDL_RWops *context, int offset, int whence)
+#else
+static Sint64 music_rw_size(SDL_RWops *context)
+{
+	return SFileGetFileSize((HANDLE)context->hidden.unknown.data1, NULL);
+}
+
+static Sint64 music_rw_seek(SDL_RWops *context, Sint64 offset, int whence)
+#endif
+{
+	int pos;
+
+	// RW_SEEK_SET, RW_SEEK_CUR and RW_SEEK_END match FILE_BEGIN, FILE_CURRENT and FILE_END
+	pos = SFileSetFilePointer((HANDLE)context->hidden.unknown.data1, offset, NULL, whence);
+	if (pos == -1)
+		return -1;
+	return (DWORD)pos;
+}
+
+#ifdef USE_SDL1
+static int music_rw_read(SDL_RWops *context, void *ptr, int size, int maxnum)
+#else
+static size_t music_rw_read(SDL_RWops *context, void *ptr, size_t size, size_t maxnum)
+#endif
+{
+	DWORD read;
+
+	if (size == 0)
+		return 0;
+	read = 0;
+	SFileReadFile((HANDLE)context->hidden.unknown.data1, ptr, size * maxnum, &read, NULL);
+	return read / size;
+}
+
+#ifdef USE_SDL1
+static int music_rw_write(SDL_RWops *context, const void *ptr, int size, int num)
+{
+	return -1;
+}
+#else
+static size_t music_rw_write(SDL_RWops *context, const void *ptr, size_t size, size_t num)
+{
+	return 0;
+}
+#endif
+
+static int music_rw_close(SDL_RWops *context)
+{
+	// the track itself is closed by music_stop
+	SDL_FreeRW(context);
+	return 0;
+}
+
+static SDL_RWops *music_rw_open(HANDLE file)
+{
+	SDL_RWops *rw;
+
+	rw = SDL_AllocRW();
+	if (rw == NULL)
+		return NULL;
+
+#ifndef USE_SDL1
+	rw->size = music_rw_size;
+	rw->type = SDL_RWOPS_UNKNOWN;
+#endif
+	rw->seek = music_rw_seek;
+	rw->read = music_rw_read;
+	rw->write = music_rw_write;
+	rw->close = music_rw_close;
+	rw->hidden.unknown.data1 = file;
+
+	return rw;
+}
+#endif
+
 void music_stop()
 {
 	if (sgpMusicTrack) {
 		Mix_HaltMusic();
-		SFileCloseFile(sgpMusicTrack);
-		sgpMusicTrack = NULL;
 		Mix_FreeMusic(music);
 		music = NULL;
 		musicRw = NULL;
+		SFileCloseFile(sgpMusicTrack);
+		sgpMusicTrack = NULL;
 		mem_free_dbg(musicBuffer);
+		musicBuffer = NULL;
 		sgnMusicTrack = NUM_MUSIC;
 	}
 }
@@ -208,11 +410,16 @@ void music_start(int nTrack)
 		if (!success) {
 			sgpMusicTrack = NULL;
 		} else {
+#ifdef VITA
+			// StormLib seeks and reads the archive there, so it can't be read on the audio thread
 			int bytestoread = SFileGetFileSize(sgpMusicTrack, 0);
 			musicBuffer = (char *)DiabloAllocPtr(bytestoread);
 			SFileReadFile(sgpMusicTrack, musicBuffer, bytestoread, NULL, 0);
 
 			musicRw = SDL_RWFromConstMem(musicBuffer, bytestoread);
+#else
+			musicRw = music_rw_open(sgpMusicTrack);
+#endif
 			if (musicRw == NULL) {
 				ErrSdl();
 			}
@@ -90,32 +90,182 @@ void TranslateFileName(char *dst, int dstLen, const char *src)
 	}
 }
 
+#ifndef VITA
+/*
+ * Speech is streamed from the archive instead of being decoded whole: a
+ * silent chunk loops on the reserved channel and SFileDdaStream, an effect on
+ * that channel, writes the speech over it a piece at a time on the audio thread.
+ */
+
+/** Silence looped on the reserved channel while speech is streamed */
+static Mix_Chunk *SFileDdaLoop;
+static Uint8 SFileDdaSilence[4096];
+/** The speech is read through this in pieces of at most its size */
+static Sint16 SFileDdaBuffer[2048];
+static HANDLE SFileDdaFile;
+static DWORD SFileDdaBytesLeft;
+static int SFileDdaChannels;
+static int SFileDdaBits;
+static int SFileDdaMixChannels;
+/** Set by the audio thread once the whole file has been played */
+static volatile bool SFileDdaDone;
+
+/**
+ * @brief Read the WAV header and set up streaming if the samples only need their channels or width converted
+ * @return false if the file has to be decoded whole, its file pointer is rewound then
+ */
+static bool SFileDdaOpenStream(HANDLE hFile)
+{
+	BYTE header[16];
+	DWORD read, size;
+	int freq, channels;
+	Uint16 format;
+	bool haveFormat = false;
+
+	if (Mix_QuerySpec(&freq, &format, &channels) == 0 || format != AUDIO_S16SYS || channels < 1 || channels > 2)
+		return false;
+	SFileDdaMixChannels = channels;
+
+	if (!SFileReadFile(hFile, header, 12, &read, NULL) || memcmp(header, "RIFF", 4) != 0 || memcmp(&header[8], "WAVE", 4) != 0) {
+		SFileSetFilePointer(hFile, 0, NULL, DVL_FILE_BEGIN);
+		return false;
+	}
+
+	while (SFileReadFile(hFile, header, 8, &read, NULL)) {
+		size = SDL_SwapLE32(*(Uint32 *)&header[4]);
+		if (memcmp(header, "data", 4) == 0) {
+			if (!haveFormat)
+				break;
+			SFileDdaFile = hFile;
+			SFileDdaBytesLeft = size;
+			SFileDdaDone = false;
+			return true;
+		}
+		if (memcmp(header, "fmt ", 4) == 0 && size >= 16) {
+			if (!SFileReadFile(hFile, header, 16, &read, NULL))
+				break;
+			SFileDdaChannels = SDL_SwapLE16(*(Uint16 *)&header[2]);
+			SFileDdaBits = SDL_SwapLE16(*(Uint16 *)&header[14]);
+			// PCM at the mixer's rate, anything else is left to SDL_mixer
+			if (SDL_SwapLE16(*(Uint16 *)&header[0]) != 1 || SDL_SwapLE32(*(Uint32 *)&header[4]) != (Uint32)freq
+			    || SFileDdaChannels < 1 || SFileDdaChannels > 2 || (SFileDdaBits != 8 && SFileDdaBits != 16))
+				break;
+			haveFormat = true;
+			size -= 16;
+		}
+		SFileSetFilePointer(hFile, size + (size & 1), NULL, DVL_FILE_CURRENT);
+	}
+
+	SFileSetFilePointer(hFile, 0, NULL, DVL_FILE_BEGIN);
+	return false;
+}
+
+static void SFileDdaStream(int chan, void *stream, int len, void *udata)
+{
+	Sint16 *out = (Sint16 *)stream;
+	Sint16 sample[2];
+	int frames, frameSize, n, i, c;
+	DWORD want, read;
+
+	frameSize = SFileDdaChannels * SFileDdaBits / 8;
+	frames = len / (SFileDdaMixChannels * 2);
+	while (frames > 0 && SFileDdaBytesLeft != 0) {
+		want = frames * frameSize;
+		if (want > sizeof(SFileDdaBuffer))
+			want = sizeof(SFileDdaBuffer) - sizeof(SFileDdaBuffer) % frameSize;
+		if (want > SFileDdaBytesLeft)
+			want = SFileDdaBytesLeft;
+		read = 0;
+		SFileReadFile(SFileDdaFile, SFileDdaBuffer, want, &read, NULL);
+		n = read / frameSize;
+		if (n == 0) {
+			SFileDdaBytesLeft = 0;
+			break;
+		}
+		SFileDdaBytesLeft -= read;
+
+		for (i = 0; i < n; i++) {
+			for (c = 0; c < SFileDdaChannels; c++) {
+				if (SFileDdaBits == 8)
+					sample[c] = (((Uint8 *)SFileDdaBuffer)[i * SFileDdaChannels + c] - 128) << 8;
+				else
+					sample[c] = SDL_SwapLE16(SFileDdaBuffer[i * SFileDdaChannels + c]);
+			}
+			if (SFileDdaChannels == 1)
+				sample[1] = sample[0];
+			if (SFileDdaMixChannels == 1) {
+				*out++ = (sample[0] + sample[1]) / 2;
+			} else {
+				*out++ = sample[0];
+				*out++ = sample[1];
+			}
+		}
+		frames -= n;
+	}
+
+	if (frames > 0) {
+		memset(out, 0, frames * SFileDdaMixChannels * 2);
+		SFileDdaDone = true;
+	}
+}
+#endif
+
 BOOL SFileDdaBeginEx(HANDLE hFile, DWORD flags, DWORD mask, unsigned __int32 lDistanceToMove,
     signed __int32 volume, signed int pan, int a7)
 {
-	DWORD bytestoread = SFileGetFileSize(hFile, 0);
-	char *SFXbuffer = (char *)malloc(bytestoread);
-	SFileReadFile(hFile, SFXbuffer, bytestoread, NULL, NULL);
+	Mix_Chunk *chunk;
+	int loops = 0;
 
-	SDL_RWops *rw = SDL_RWFromConstMem(SFXbuffer, bytestoread);
-	if (rw == NULL) {
-		SDL_Log(SDL_GetError());
-		return false;
+	Mix_HaltChannel(0);
+	Mix_UnregisterAllEffects(0);
+	Mix_FreeChunk(SFileChunk);
+	SFileChunk = NULL;
+
+#ifndef VITA
+	if (SFileDdaOpenStream(hFile)) {
+		if (SFileDdaLoop == NULL)
+			SFileDdaLoop = Mix_QuickLoad_RAW(SFileDdaSilence, sizeof(SFileDdaSilence));
+		if (SFileDdaLoop == NULL || !Mix_RegisterEffect(0, SFileDdaStream, NULL, NULL)) {
+			SDL_Log(Mix_GetError());
+			return false;
+		}
+		chunk = SFileDdaLoop;
+		loops = -1;
+	} else
+#endif
+	{
+		DWORD bytestoread = SFileGetFileSize(hFile, 0);
+		char *SFXbuffer = (char *)malloc(bytestoread);
+		SFileReadFile(hFile, SFXbuffer, bytestoread, NULL, NULL);
+
+		SDL_RWops *rw = SDL_RWFromConstMem(SFXbuffer, bytestoread);
+		if (rw == NULL) {
+			SDL_Log(SDL_GetError());
+			free(SFXbuffer);
+			return false;
+		}
+		SFileChunk = Mix_LoadWAV_RW(rw, 1);
+		free(SFXbuffer);
+		chunk = SFileChunk;
 	}
-	SFileChunk = Mix_LoadWAV_RW(rw, 1);
-	free(SFXbuffer);
 
 	Mix_Volume(0, MIX_MAX_VOLUME - MIX_MAX_VOLUME * volume / VOLUME_MIN);
 	int panned = 255 - 255 * abs(pan) / 10000;
 	Mix_SetPanning(0, pan <= 0 ? 255 : panned, pan >= 0 ? 255 : panned);
-	Mix_PlayChannel(0, SFileChunk, 0);
+	Mix_PlayChannel(0, chunk, loops);
 
 	return true;
 }
 
 BOOL SFileDdaDestroy()
 {
+	Mix_HaltChannel(0);
 	Mix_FreeChunk(SFileChunk);
+	SFileChunk = NULL;
+#ifndef VITA
+	Mix_FreeChunk(SFileDdaLoop);
+	SFileDdaLoop = NULL;
+#endif
 
 	return true;
 }
@@ -123,16 +273,30 @@ BOOL SFileDdaDestroy()
 BOOL SFileDdaEnd(HANDLE hFile)
 {
 	Mix_HaltChannel(0);
+#ifndef VITA
+	// the stream effect went with the halt, the caller may close the file now
+	SFileDdaFile = NULL;
+#endif
 
 	return true;
 }
 
 BOOL SFileDdaGetPos(HANDLE hFile, DWORD *current, DWORD *end)
 {
+	Mix_Chunk *chunk;
+
 	*current = 0;
 	*end = 1;
 
-	if (Mix_GetChunk(0) != SFileChunk || !Mix_Playing(0)) {
+	chunk = Mix_GetChunk(0);
+	if (!Mix_Playing(0) || chunk == NULL) {
+		*current = *end;
+#ifndef VITA
+	} else if (chunk == SFileDdaLoop) {
+		if (SFileDdaDone)
+			*current = *end;
+#endif
+	} else if (chunk != SFileChunk) {
 		*current = *end;
 	}
 
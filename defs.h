@@ -62,6 +62,32 @@
 
 #define MAXPATHNODES			300
 
+// upper bound for the "Render Threads" setting
+#define MAX_RENDER_THREADS		8
+
+// saves waiting for the save thread before SaveLevel/pfile_write_hero block
+#define MAX_SAVE_JOBS			8
+// save timing histogram, bucket i counts saves under 2^i ms, the last one the rest
+#define SAVE_HIST_BUCKETS		12
+
+// tiles from a stairway or portal at which the next level's graphics start loading
+#define PREFETCH_RADIUS			8
+// files the prefetch thread stages for one level: tiles plus every monster animation
+#define MAX_PREFETCH_FILES		(4 + MAX_LVLMTYPES * 6)
+
+// most armour/weapon combinations of one class kept loaded for gear swaps
+#define MAX_PLRGFX_SETS			8
+// animation files of a player, one per player_graphic bit
+#define NUM_PLRGFX_FILES		9
+
+// frames queued for or held by the presenter thread
+#define MAX_PRESENT_FRAMES		3
+// screen updates one queued frame can carry
+#define MAX_PRESENT_RECTS		32
+
+// frames the profiler overlay takes percentiles over
+#define PROFILE_FRAMES			128
+
 // 256 kilobytes + 3 bytes (demo leftover) for file magic (262147)
 // final game uses 4-byte magic instead of 3
 #define FILEBUFF				((256*1024)+3)
@@ -150,6 +176,14 @@
 	mem_free_dbg(p__p);	\
 }
 
+#define MemFreeView(p)		\
+{							\
+	BYTE *p__p;				\
+	p__p = (BYTE *)p;		\
+	p = NULL;				\
+	ReleaseFileView(p__p);	\
+}
+
 #undef assert
 
 #ifndef _DEBUG
@@ -2931,3 +2931,25 @@ typedef enum conn_type {
 #endif
 	SELCONN_LOOPBACK,
 } conn_type;
+
+typedef enum profile_zone {
+	PROF_PLAYERS,
+	PROF_MONSTERS,
+	PROF_OBJECTS,
+	PROF_MISSILES,
+	PROF_ITEMS,
+	PROF_LIGHTS,
+	PROF_VISION,
+	PROF_NETWORK,
+	PROF_DRAWGAME,
+	PROF_DRAWVIEW,
+	PROF_PRESENT,
+	NUM_PROFILE_ZONES,
+} profile_zone;
+
+typedef enum item_list_kind {
+	ILIST_DROP,
+	ILIST_GOOD,
+	ILIST_ALL,
+	NUM_ITEM_LISTS,
+} item_list_kind;
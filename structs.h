@@ -530,37 +530,40 @@ typedef struct CMonster {
 	BYTE *trans_file;
 } CMonster;
 
+/**
+ * Fields are grouped by how often ProcessMonsters touches them, the per-tick
+ * ones first so an idle monster costs one or two cache lines. The order in
+ * memory doesn't matter to saves and sync, they copy the fields one by one in
+ * the original order, the falign names refer to those save offsets.
+ */
 typedef struct MonsterStruct { // note: missing field _mAFNum
-	int _mMTidx;
+	// touched for every active monster each tick
 	int _mmode; /* MON_MODE */
-	unsigned char _mgoal;
-	int _mgoalvar1;
-	int _mgoalvar2;
-	int _mgoalvar3;
-	int field_18;
-	unsigned char _pathcount;
+	int _mFlags;
+	int _mhitpoints;
+	int _mmaxhp;
 	int _mx;
 	int _my;
 	int _mfutx;
 	int _mfuty;
-	int _moldx;
-	int _moldy;
-	int _mxoff;
-	int _myoff;
-	int _mxvel;
-	int _myvel;
-	int _mdir;
 	int _menemy;
+	int _lastx;
+	int _lasty;
+	int _mAISeed;
 	unsigned char _menemyx;
 	unsigned char _menemyy;
-	short falign_52; // probably _mAFNum (unused)
-	unsigned char *_mAnimData;
-	int _mAnimDelay;
+	BYTE _msquelch;
+	unsigned char _mAi;
+	char mLevel;
+	unsigned char _mint;
 	int _mAnimCnt;
-	int _mAnimLen;
+	int _mAnimDelay;
 	int _mAnimFrame;
-	BOOL _meflag;
-	BOOL _mDelFlag;
+	int _mAnimLen;
+	int _mdir;
+	unsigned char *_mAnimData;
+	CMonster *MType;
+	// touched by the modes and AI once the monster is active
 	int _mVar1;
 	int _mVar2;
 	int _mVar3;
@@ -569,25 +572,30 @@ typedef struct MonsterStruct { // note: missing field _mAFNum
 	int _mVar6;
 	int _mVar7;
 	int _mVar8;
-	int _mmaxhp;
-	int _mhitpoints;
-	unsigned char _mAi;
-	unsigned char _mint;
-	short falign_9A;
-	int _mFlags;
-	BYTE _msquelch;
-	int falign_A4;
-	int _lastx;
-	int _lasty;
+	int _mxoff;
+	int _myoff;
+	int _mxvel;
+	int _myvel;
+	int _moldx;
+	int _moldy;
+	unsigned char _mgoal;
+	unsigned char _pathcount;
+	unsigned char leader;
+	unsigned char leaderflag;
+	int _mgoalvar1;
+	int _mgoalvar2;
+	int _mgoalvar3;
+	BOOL _meflag;
+	BOOL _mDelFlag;
+	// combat stats, naming and the rest
+	int _mMTidx;
 	int _mRndSeed;
-	int _mAISeed;
-	int falign_B8;
 	unsigned char _uniqtype;
 	unsigned char _uniqtrans;
 	char _udeadval;
 	char mWhoHit;
-	char mLevel;
 	unsigned short mExp;
+	unsigned short mMagicRes;
 	unsigned char mHit;
 	unsigned char mMinDamage;
 	unsigned char mMaxDamage;
@@ -595,15 +603,16 @@ typedef struct MonsterStruct { // note: missing field _mAFNum
 	unsigned char mMinDamage2;
 	unsigned char mMaxDamage2;
 	unsigned char mArmorClass;
-	char falign_CB;
-	unsigned short mMagicRes;
-	int mtalkmsg;
-	unsigned char leader;
-	unsigned char leaderflag;
 	unsigned char packsize;
+	int mtalkmsg;
 	unsigned char mlid;
+	char falign_CB;
+	short falign_52; // probably _mAFNum (unused)
+	short falign_9A;
+	int field_18;
+	int falign_A4;
+	int falign_B8;
 	char *mName;
-	CMonster *MType;
 	MonsterData *MData;
 } MonsterStruct;
 